@@ -75,6 +75,8 @@ async function autoCalibrate(sensorIndex) {
           
           // Nach erfolgreichem Auto-Kalibrieren Seite neu laden:
           window.location.reload();
+      } else if(result.status === "no_adc") {
+          throw new Error('ADS1115 nicht gefunden (siehe /api/health)');
       } else {
           throw new Error('Kalibrierung fehlgeschlagen');
       }
@@ -48,6 +48,12 @@ document.addEventListener('DOMContentLoaded', function() {
     .catch(error => console.error("Fehler beim Laden der Diagrammdaten:", error));
 });
 
+// Kennwerte unabhängig von den Diagrammen laden und alle 5 Sekunden aktualisieren
+document.addEventListener('DOMContentLoaded', function() {
+  updateStats();
+  setInterval(updateStats, 5000);
+});
+
 // ======================================================================
 // Funktion: Daten sortieren (nach Timestamp-String)
 // ======================================================================
@@ -314,3 +320,67 @@ function downloadChart(canvasId, filename) {
   link.download = filename;
   link.click();
 }
+
+// ======================================================================
+// Kennwerte je Kanal (Sitzung und zwei gleitende Fenster) aus /api/stats
+// ======================================================================
+const statsLabels = {
+  p1: "Druck 1 (bar)", p2: "Druck 2 (bar)", p3: "Druck 3 (bar)", p4: "Druck 4 (bar)",
+  f1: "Durchfluss 1 (L/min)", f2: "Durchfluss 2 (L/min)",
+  dp12: "Differenz 1-2 (bar)", dp34: "Differenz 3-4 (bar)",
+  ppf1: "Differenz 1-2 / Durchfluss 1", ppf2: "Differenz 3-4 / Durchfluss 2"
+};
+
+function formatStat(v) {
+  return (v === null || v === undefined) ? "–" : v;
+}
+
+function updateStats() {
+  fetch('/api/stats')
+    .then(response => response.json())
+    .then(stats => {
+      const w = stats.windows;
+      w.forEach((s, i) => {
+        const input = document.getElementById("statsWindow" + i);
+        if (input && document.activeElement !== input) input.value = s;
+      });
+      let html = "<tr><th>Kanal</th><th>Mittel</th><th>Std</th><th>Min</th><th>Max</th>" +
+                 "<th>P50</th><th>P90</th><th>P99</th>";
+      w.forEach(s => { html += `<th>Mittel ${s / 60} min</th><th>Std ${s / 60} min</th>`; });
+      html += "</tr>";
+      for (const [key, c] of Object.entries(stats.channels)) {
+        html += `<tr><td>${statsLabels[key] || key}</td>`;
+        ["mean", "std", "min", "max", "p50", "p90", "p99"].forEach(f => {
+          html += `<td>${formatStat(c[f])}</td>`;
+        });
+        w.forEach(s => {
+          const win = c["w" + s];
+          html += `<td>${formatStat(win[0])}</td><td>${formatStat(win[1])}</td>`;
+        });
+        html += "</tr>";
+      }
+      document.getElementById("statsTable").innerHTML = html;
+    })
+    .catch(error => console.error("Fehler beim Laden der Kennwerte:", error));
+}
+
+function resetStats() {
+  fetch('/resetStats')
+    .then(response => response.text())
+    .then(() => updateStats())
+    .catch(error => console.error("Fehler beim Zurücksetzen der Kennwerte:", error));
+}
+
+function setStatsWindows() {
+  const body = {
+    w0: parseInt(document.getElementById("statsWindow0").value, 10),
+    w1: parseInt(document.getElementById("statsWindow1").value, 10)
+  };
+  fetch('/api/stats', {
+    method: 'POST',
+    headers: { 'Content-Type': 'application/json' },
+    body: JSON.stringify(body)
+  })
+    .then(response => response.ok ? updateStats() : response.text().then(text => alert(text)))
+    .catch(error => console.error("Fehler beim Setzen der Fenster:", error));
+}
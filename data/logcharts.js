@@ -26,8 +26,17 @@ document.addEventListener('DOMContentLoaded', () => {
   }
 
   // 2) Daten von /api/logdata?name=... laden und Diagramme erstellen
-  fetch('/api/logdata?name=' + encodeURIComponent(logFileName))
+  //    Optionale URL-Parameter from/to (Unix-Zeit) und max (Punkte) werden durchgereicht,
+  //    damit der ESP32 nur das gewünschte Zeitfenster liefert.
+  let query = '/api/logdata?name=' + encodeURIComponent(logFileName);
+  ['from', 'to', 'step', 'max'].forEach(key => {
+    if (urlParams.has(key)) query += '&' + key + '=' + encodeURIComponent(urlParams.get(key));
+  });
+  if (!urlParams.has('step') && !urlParams.has('max')) query += '&max=3000';
+
+  fetch(query)
     .then(response => response.json())
+    .then(rowsToColumns)
     .then(data => {
       createPressureChart(data);
       createFlowChart(data);
@@ -47,6 +56,22 @@ document.addEventListener('DOMContentLoaded', () => {
   });
 });
 
+// /api/logdata liefert Zeilen [Zeit, Druck1..4, Flow1..2] – für Chart.js in Spalten umwandeln
+function rowsToColumns(json) {
+  const data = {
+    timestamps: [],
+    pressure: { sensor1: [], sensor2: [], sensor3: [], sensor4: [] },
+    flow: { sensor1: [], sensor2: [] }
+  };
+  json.rows.forEach(row => {
+    data.timestamps.push(row[0]);
+    for (let i = 1; i <= 4; i++) data.pressure[`sensor${i}`].push(row[i]);
+    data.flow.sensor1.push(row[5]);
+    data.flow.sensor2.push(row[6]);
+  });
+  return data;
+}
+
 // Druckdiagramm erstellen
 function createPressureChart(data) {
   const ctx = document.getElementById('pressureChart').getContext('2d');
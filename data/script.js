@@ -37,6 +37,7 @@ document.addEventListener('DOMContentLoaded', () => {
   // a) Text-Updates (Sensorwerte) alle 1 Sekunde
   setInterval(updateData, 1000);
   updateData();
+  startEventStream();                             // Ereignisse per Push
 
   // b) Diagramme initial erstellen
   initLoggingCharts();
@@ -75,23 +76,84 @@ function updateData() {
       // Zeitanzeige
       document.getElementById('timeDisplay').innerText = 'Zeit: ' + data.time;
       
-      // Drucksensorwerte
+      // Drucksensorwerte (ohne ADS1115 läuft die Station ohne Druckmessung weiter)
       let pressureHtml = '';
-      data.pressure.forEach((p, i) => {
-        pressureHtml += `<p>Sensor ${i+1}: ${p.toFixed(3)} bar</p>`;
-      });
+      if (data.adc === false) {
+        pressureHtml = '<p>ADS1115 nicht gefunden – keine Druckwerte (siehe <a href="/api/health">/api/health</a>)</p>';
+      } else {
+        data.pressure.forEach((p, i) => {
+          // null: ADS1115 gerade erst (wieder) gefunden, noch kein Messwert
+          pressureHtml += `<p>Sensor ${i+1}: ${p === null ? '–' : p.toFixed(3)} bar</p>`;
+        });
+      }
       document.getElementById('pressureData').innerHTML = pressureHtml;
       
       // Durchflusswerte
       let flowHtml = `<p>Sensor 1: ${data.flowRate[0].toFixed(2)} L/min (kUm: ${data.cumulativeFlow[0].toFixed(2)} L)</p>
                       <p>Sensor 2: ${data.flowRate[1].toFixed(2)} L/min (kUm: ${data.cumulativeFlow[1].toFixed(2)} L)</p>`;
       document.getElementById('flowData').innerHTML = flowHtml;
+
+      // Ereignisse (nur nachladen, wenn die Station ein neues gemeldet hat)
+      checkEvents(data.eventId, data.alarms);
     })
     .catch(error => {
       console.error('Fehler beim Abrufen der Daten:', error);
     });
 }
 
+// ------------------------------------
+// 2b) Ereignisse der Regelüberwachung:
+//     kommen per Server-Sent Events (/api/events/stream) im Messzyklus an;
+//     ohne Stream (alle Plätze belegt, alter Browser) wird /api/events nur
+//     abgefragt, wenn sich die Ereignisnummer geändert hat
+// ------------------------------------
+let lastEventId = 0;
+let eventsLoading = false;
+let eventSource = null;
+const eventLines = [];
+
+function showEvents(events) {
+  events.forEach(e => {
+    const name = e.name || `Regel ${e.rule + 1}`;
+    eventLines.unshift(`<p>${e.time} – ${name}: ${e.active ? 'ausgelöst' : 'beendet'} (${e.value.toFixed(3)})</p>`);
+    lastEventId = e.id;
+  });
+  eventLines.splice(10);                          // nur die letzten 10 anzeigen
+  document.getElementById('eventData').innerHTML = eventLines.length ? eventLines.join('') : 'Keine Ereignisse';
+}
+
+function startEventStream() {
+  if (!window.EventSource) return;
+  // Nach Unterbrechungen verbindet sich der Browser selbst neu und meldet Last-Event-ID
+  eventSource = new EventSource('/api/events/stream?since=' + lastEventId);
+  eventSource.onmessage = msg => showEvents([JSON.parse(msg.data)]);
+  eventSource.onerror = () => {
+    // Abgewiesen (503) oder endgültig geschlossen: weiter über die Ereignisnummer
+    if (eventSource.readyState === EventSource.CLOSED) eventSource = null;
+  };
+}
+
+function checkEvents(eventId, alarms) {
+  document.getElementById('eventCard').classList.toggle('alarm', alarms > 0);
+  if (eventSource) return;                        // Ereignisse kommen per Push
+  if (eventId === undefined || eventId === lastEventId || eventsLoading) return;
+  if (eventId < lastEventId) lastEventId = 0;     // Station wurde neu gestartet
+
+  eventsLoading = true;
+  fetch('/api/events?since=' + lastEventId)
+    .then(response => response.json())
+    .then(data => {
+      showEvents(data.events);
+      lastEventId = data.lastId;
+    })
+    .catch(error => {
+      console.error('Fehler beim Abrufen der Ereignisse:', error);
+    })
+    .finally(() => {
+      eventsLoading = false;
+    });
+}
+
 // ------------------------------------
 // 3) Diagramme (Logging-Daten):
 //    Initialisierung + Update
@@ -317,7 +379,7 @@ function toggleRecording() {
     .catch(err => console.error("Fehler bei toggleRecording:", err));
 }
 
-// 5) CSV direkt herunterladen
+// 5) CSV direkt herunterladen (der Server unterstützt Range, abgebrochene Downloads werden fortgesetzt)
 function downloadLog() {
   window.location.href = '/downloadlog';
 }
@@ -380,9 +442,19 @@ function calibrateVmin(sensorIndex) {
 }
 
 // ------------------------------------
-// 11) CSV + Diagramme -> ZIP (überarbeitete Version)
+// 11) CSV + Diagramme herunterladen
+//     Die CSV-Logs komprimiert der ESP32 selbst und streamt sie als ZIP direkt
+//     auf die Platte (nichts davon liegt im Browser-Speicher). Die Diagramme
+//     (PNG) sind ein eigener, kleiner Download.
 // ------------------------------------
-async function downloadAllData() {
+function downloadAllData() {
+  const link = document.createElement('a');
+  link.href = '/downloadzip';
+  link.download = getFileTimestampJS() + "_Logs.zip";
+  link.click();
+}
+
+async function downloadCharts() {
   // 1) Check, ob FileSaver und JSZip geladen sind
   if (typeof saveAs === "undefined") {
     alert("FileSaver ist nicht geladen.");
@@ -396,19 +468,7 @@ async function downloadAllData() {
   const zip = new JSZip();
   const timestamp = getFileTimestampJS();
 
-  // a) CSV laden und ins ZIP packen
-  try {
-    const csvResp = await fetch('/downloadlog');
-    if (!csvResp.ok) throw new Error("CSV (HTTP " + csvResp.status + ")");
-    const csvText = await csvResp.text();
-    zip.file(timestamp + "_Rohdaten.csv", csvText);
-  } catch (e) {
-    console.error("Fehler beim CSV:", e);
-    alert("Fehler beim Laden der CSV");
-    return;
-  }
-
-  // b) Funktion, die ein Off-Screen-Canvas erstellt, skaliert den Inhalt und einen weißen Hintergrund setzt.
+  // a) Funktion, die ein Off-Screen-Canvas erstellt, skaliert den Inhalt und einen weißen Hintergrund setzt.
   function getHighResCanvasAsBase64(canvasId, scaleFactor = 4) {
     const originalCanvas = document.getElementById(canvasId);
     if (!originalCanvas) {
@@ -431,7 +491,7 @@ async function downloadAllData() {
     return offScreenCanvas.toDataURL("image/png").split(",")[1];
   }
 
-  // c) Diagramme exportieren: Für jeden Chart ein Bild in höherer Auflösung erzeugen
+  // b) Diagramme exportieren: Für jeden Chart ein Bild in höherer Auflösung erzeugen
   const pData = getHighResCanvasAsBase64("pressureChart", 4);
   if (pData) zip.file(timestamp + "_Druck.png", pData, { base64: true });
   const fData = getHighResCanvasAsBase64("flowChart", 4);
@@ -439,10 +499,10 @@ async function downloadAllData() {
   const cData = getHighResCanvasAsBase64("combinedChart", 4);
   if (cData) zip.file(timestamp + "_Kombiniert.png", cData, { base64: true });
 
-  // d) ZIP generieren und herunterladen
+  // c) ZIP generieren und herunterladen
   try {
     const blob = await zip.generateAsync({ type: "blob" });
-    saveAs(blob, timestamp + "_Log_Diagramme.zip");
+    saveAs(blob, timestamp + "_Diagramme.zip");
   } catch (err) {
     console.error("Fehler beim ZIP:", err);
     alert("Fehler beim Erstellen der ZIP-Datei");
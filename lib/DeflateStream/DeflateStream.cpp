@@ -0,0 +1,386 @@
+/*****************************************************
+ * DeflateStream.cpp – Implementierung von CRC-32, Deflate, gzip und ZIP
+ *
+ * Der Encoder erzeugt einen einzigen Deflate-Block mit festen Huffman-Codes
+ * (BTYPE = 01). Damit entfällt der Aufbau dynamischer Code-Tabellen, und
+ * der Speicherbedarf bleibt unabhängig von der Dateigröße konstant.
+ * Für die CSV-Logs (viele wiederkehrende Ziffern/Trennzeichen) wird damit
+ * je nach Messwertrauschen etwa ein Faktor 2 bis 4 erreicht.
+ *****************************************************/
+#include "DeflateStream.h"
+
+#include <new>
+#include <string.h>
+#include <time.h>
+
+/* ====================================================
+ * 1. CRC-32 (Polynom 0xEDB88320, Halbbyte-Tabelle)
+ * ==================================================== */
+static const uint32_t CRC_NIBBLE[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+  0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+  0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len) {
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ CRC_NIBBLE[crc & 0x0F];
+    crc = (crc >> 4) ^ CRC_NIBBLE[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+/* ====================================================
+ * 2. Deflate mit festen Huffman-Codes
+ * ==================================================== */
+// Basislängen und Extra-Bits der Längencodes 257..285
+static const uint16_t LENGTH_BASE[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t LENGTH_EXTRA[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+// Basisdistanzen und Extra-Bits der Distanzcodes 0..29
+static const uint16_t DIST_BASE[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t DIST_EXTRA[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static inline uint16_t hash3(const uint8_t* p) {
+  uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+  return (uint16_t)((v * 2654435761u) >> 22) & (DeflateEncoder::HASH_SIZE - 1);
+}
+
+void DeflateEncoder::begin(DeflateSink sink, void* ctx) {
+  _sink = sink;
+  _ctx = ctx;
+  memset(_head, 0, sizeof(_head));
+  _pos = 0;
+  _end = 0;
+  _bitBuf = 0;
+  _bitCount = 0;
+  _outLen = 0;
+  _bytesOut = 0;
+
+  // Blockkopf: BFINAL = 1, BTYPE = 01 (feste Huffman-Codes)
+  putBits(1, 1);
+  putBits(1, 2);
+}
+
+void DeflateEncoder::write(const uint8_t* data, size_t len) {
+  while (len > 0) {
+    size_t n = BUF_SIZE - _end;
+    if (n > len) n = len;
+    memcpy(_buf + _end, data, n);
+    _end += n;
+    data += n;
+    len -= n;
+
+    if (_end == BUF_SIZE) {
+      // Vorschau von MAX_MATCH Bytes stehen lassen, dann Fenster verschieben
+      compress(_end - MAX_MATCH);
+      slide();
+    }
+  }
+}
+
+void DeflateEncoder::finish() {
+  compress(_end);
+  putHuffman(0, 7);                 // Symbol 256 = Blockende
+  if (_bitCount > 0) {
+    putBits(0, 8 - _bitCount);      // auf volles Byte auffüllen
+  }
+  flushOut();
+}
+
+void DeflateEncoder::compress(size_t limit) {
+  while (_pos < limit) {
+    size_t bestLen = 0;
+    size_t bestDist = 0;
+
+    if (_end - _pos >= MIN_MATCH) {
+      uint16_t h = hash3(_buf + _pos);
+      size_t cand = _head[h];
+      _head[h] = (uint16_t)(_pos + 1);
+
+      if (cand != 0) {
+        cand -= 1;
+        size_t dist = _pos - cand;
+        if (dist > 0 && dist <= WINDOW_SIZE) {
+          size_t maxLen = _end - _pos;
+          if (maxLen > MAX_MATCH) maxLen = MAX_MATCH;
+          size_t len = 0;
+          while (len < maxLen && _buf[cand + len] == _buf[_pos + len]) len++;
+          if (len >= MIN_MATCH) {
+            bestLen = len;
+            bestDist = dist;
+          }
+        }
+      }
+    }
+
+    if (bestLen > 0) {
+      putMatch(bestLen, bestDist);
+      // Positionen innerhalb des Treffers ebenfalls in die Hash-Tabelle eintragen
+      for (size_t i = 1; i < bestLen && _pos + i + MIN_MATCH <= _end; i++) {
+        _head[hash3(_buf + _pos + i)] = (uint16_t)(_pos + i + 1);
+      }
+      _pos += bestLen;
+    } else {
+      putLiteral(_buf[_pos]);
+      _pos++;
+    }
+  }
+}
+
+void DeflateEncoder::slide() {
+  size_t shift = _pos - WINDOW_SIZE;
+  memmove(_buf, _buf + shift, _end - shift);
+  _end -= shift;
+  _pos -= shift;
+  for (size_t i = 0; i < HASH_SIZE; i++) {
+    _head[i] = (_head[i] > shift) ? (uint16_t)(_head[i] - shift) : 0;
+  }
+}
+
+void DeflateEncoder::putBits(uint32_t value, uint8_t count) {
+  _bitBuf |= value << _bitCount;
+  _bitCount += count;
+  while (_bitCount >= 8) {
+    _out[_outLen++] = (uint8_t)_bitBuf;
+    _bitBuf >>= 8;
+    _bitCount -= 8;
+    if (_outLen == OUT_SIZE) flushOut();
+  }
+}
+
+// Huffman-Codes werden MSB-zuerst übertragen, der Bitstrom ist LSB-zuerst
+void DeflateEncoder::putHuffman(uint16_t code, uint8_t len) {
+  uint16_t rev = 0;
+  for (uint8_t i = 0; i < len; i++) {
+    rev = (uint16_t)((rev << 1) | ((code >> i) & 1));
+  }
+  putBits(rev, len);
+}
+
+void DeflateEncoder::putLiteral(uint8_t lit) {
+  if (lit < 144) putHuffman(0x30 + lit, 8);
+  else           putHuffman(0x190 + (lit - 144), 9);
+}
+
+void DeflateEncoder::putMatch(size_t length, size_t distance) {
+  uint8_t li = 28;
+  while (LENGTH_BASE[li] > length) li--;
+  uint16_t sym = 257 + li;
+  if (sym < 280) putHuffman(sym - 256, 7);
+  else           putHuffman(0xC0 + (sym - 280), 8);
+  if (LENGTH_EXTRA[li]) putBits(length - LENGTH_BASE[li], LENGTH_EXTRA[li]);
+
+  uint8_t di = 29;
+  while (DIST_BASE[di] > distance) di--;
+  putHuffman(di, 5);
+  if (DIST_EXTRA[di]) putBits(distance - DIST_BASE[di], DIST_EXTRA[di]);
+}
+
+void DeflateEncoder::flushOut() {
+  if (_outLen == 0) return;
+  _sink(_ctx, _out, _outLen);
+  _bytesOut += _outLen;
+  _outLen = 0;
+}
+
+/* ====================================================
+ * 3. gzip-Rahmen
+ * ==================================================== */
+static void putLE32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static void putLE16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+void GzipWriter::begin(DeflateSink sink, void* ctx, uint32_t mtime) {
+  _sink = sink;
+  _ctx = ctx;
+  _crc = 0;
+  _size = 0;
+
+  // ID1 ID2 CM FLG MTIME(4) XFL OS
+  uint8_t header[10] = {0x1F, 0x8B, 0x08, 0x00, 0, 0, 0, 0, 0x00, 0xFF};
+  putLE32(header + 4, mtime);
+  _sink(_ctx, header, sizeof(header));
+  _deflate.begin(sink, ctx);
+}
+
+void GzipWriter::write(const uint8_t* data, size_t len) {
+  _crc = crc32Update(_crc, data, len);
+  _size += len;
+  _deflate.write(data, len);
+}
+
+void GzipWriter::finish() {
+  _deflate.finish();
+  uint8_t trailer[8];
+  putLE32(trailer, _crc);
+  putLE32(trailer + 4, _size);
+  _sink(_ctx, trailer, sizeof(trailer));
+}
+
+/* ====================================================
+ * 4. ZIP-Archiv (gestreamt, mit Datendeskriptoren)
+ * ==================================================== */
+static void toDosTime(uint32_t unixTime, uint16_t& dosTime, uint16_t& dosDate) {
+  time_t t = (time_t)unixTime;
+  struct tm tmStruct;
+  localtime_r(&t, &tmStruct);
+  if (tmStruct.tm_year < 80) {
+    // ZIP kennt keine Daten vor 1980 (z.B. wenn die Uhrzeit nie gesetzt wurde)
+    dosTime = 0;
+    dosDate = (1 << 5) | 1;
+    return;
+  }
+  dosTime = (uint16_t)((tmStruct.tm_hour << 11) | (tmStruct.tm_min << 5) | (tmStruct.tm_sec / 2));
+  dosDate = (uint16_t)(((tmStruct.tm_year - 80) << 9) | ((tmStruct.tm_mon + 1) << 5) | tmStruct.tm_mday);
+}
+
+ZipWriter::~ZipWriter() {
+  delete[] _entries;
+}
+
+bool ZipWriter::begin(DeflateSink sink, void* ctx, uint16_t maxEntries, bool deflate) {
+  delete[] _entries;
+  _entries = new (std::nothrow) Entry[maxEntries > 0 ? maxEntries : 1];
+  _maxEntries = _entries ? maxEntries : 0;
+  _sink = sink;
+  _ctx = ctx;
+  _useDeflate = deflate;
+  _inEntry = false;
+  _count = 0;
+  _offset = 0;
+  return _entries != nullptr;
+}
+
+void ZipWriter::emit(const uint8_t* data, size_t len) {
+  _sink(_ctx, data, len);
+  _offset += len;
+}
+
+void ZipWriter::countingSink(void* ctx, const uint8_t* data, size_t len) {
+  static_cast<ZipWriter*>(ctx)->emit(data, len);
+}
+
+bool ZipWriter::beginEntry(const char* name, uint32_t unixTime) {
+  if (_inEntry || _count >= _maxEntries) return false;
+
+  Entry& e = _entries[_count];
+  strncpy(e.name, name, NAME_LEN - 1);
+  e.name[NAME_LEN - 1] = '\0';
+  toDosTime(unixTime, e.dosTime, e.dosDate);
+  e.crc = 0;
+  e.size = 0;
+  e.compSize = 0;
+  e.offset = _offset;
+
+  uint16_t nameLen = (uint16_t)strlen(e.name);
+  uint8_t header[30];
+  putLE32(header, 0x04034B50);
+  putLE16(header + 4, 20);                       // benötigte Version 2.0
+  putLE16(header + 6, 0x0008);                   // Größen folgen im Datendeskriptor
+  putLE16(header + 8, _useDeflate ? 8 : 0);
+  putLE16(header + 10, e.dosTime);
+  putLE16(header + 12, e.dosDate);
+  putLE32(header + 14, 0);                       // CRC
+  putLE32(header + 18, 0);                       // komprimierte Größe
+  putLE32(header + 22, 0);                       // Originalgröße
+  putLE16(header + 26, nameLen);
+  putLE16(header + 28, 0);                       // kein Extra-Feld
+  emit(header, sizeof(header));
+  emit((const uint8_t*)e.name, nameLen);
+
+  _entryStart = _offset;
+  if (_useDeflate) _deflate.begin(countingSink, this);
+  _inEntry = true;
+  return true;
+}
+
+void ZipWriter::write(const uint8_t* data, size_t len) {
+  if (!_inEntry) return;
+  Entry& e = _entries[_count];
+  e.crc = crc32Update(e.crc, data, len);
+  e.size += len;
+  if (_useDeflate) _deflate.write(data, len);
+  else             emit(data, len);
+}
+
+void ZipWriter::endEntry() {
+  if (!_inEntry) return;
+  if (_useDeflate) _deflate.finish();
+
+  Entry& e = _entries[_count];
+  e.compSize = _offset - _entryStart;
+
+  uint8_t desc[16];
+  putLE32(desc, 0x08074B50);
+  putLE32(desc + 4, e.crc);
+  putLE32(desc + 8, e.compSize);
+  putLE32(desc + 12, e.size);
+  emit(desc, sizeof(desc));
+
+  _count++;
+  _inEntry = false;
+}
+
+void ZipWriter::finish() {
+  endEntry();
+
+  uint32_t cdStart = _offset;
+  for (uint16_t i = 0; i < _count; i++) {
+    const Entry& e = _entries[i];
+    uint16_t nameLen = (uint16_t)strlen(e.name);
+    uint8_t header[46];
+    putLE32(header, 0x02014B50);
+    putLE16(header + 4, 20);                     // erstellt mit Version 2.0
+    putLE16(header + 6, 20);                     // benötigte Version 2.0
+    putLE16(header + 8, 0x0008);
+    putLE16(header + 10, _useDeflate ? 8 : 0);
+    putLE16(header + 12, e.dosTime);
+    putLE16(header + 14, e.dosDate);
+    putLE32(header + 16, e.crc);
+    putLE32(header + 20, e.compSize);
+    putLE32(header + 24, e.size);
+    putLE16(header + 28, nameLen);
+    putLE16(header + 30, 0);                     // Extra-Feld
+    putLE16(header + 32, 0);                     // Kommentar
+    putLE16(header + 34, 0);                     // Disk-Nummer
+    putLE16(header + 36, 0);                     // interne Attribute
+    putLE32(header + 38, 0);                     // externe Attribute
+    putLE32(header + 42, e.offset);
+    emit(header, sizeof(header));
+    emit((const uint8_t*)e.name, nameLen);
+  }
+
+  uint8_t eocd[22];
+  putLE32(eocd, 0x06054B50);
+  putLE16(eocd + 4, 0);
+  putLE16(eocd + 6, 0);
+  putLE16(eocd + 8, _count);
+  putLE16(eocd + 10, _count);
+  putLE32(eocd + 12, _offset - cdStart);
+  putLE32(eocd + 16, cdStart);
+  putLE16(eocd + 20, 0);
+  emit(eocd, sizeof(eocd));
+}
@@ -0,0 +1,120 @@
+/*****************************************************
+ * DeflateStream.h – Speichersparende Kompression für Exporte
+ *
+ * Enthält:
+ *   - crc32Update():   CRC-32 (wie gzip/ZIP) ohne 1-KB-Tabelle
+ *   - DeflateEncoder:  Deflate (RFC 1951) mit festen Huffman-Codes und
+ *                      kleinem LZ77-Fenster (4 KB) – ca. 11 KB RAM
+ *   - GzipWriter:      gzip-Rahmen (RFC 1952) um den DeflateEncoder
+ *   - ZipWriter:       ZIP-Archiv mit mehreren Einträgen, die nacheinander
+ *                      gestreamt werden (Datendeskriptoren, da die Größe
+ *                      vorher unbekannt ist)
+ *
+ * Alle Ausgaben gehen über eine Sink-Funktion hinaus, damit die Daten
+ * ohne Zwischenspeicherung direkt an den HTTP-Client geschickt werden
+ * können. Die Bibliothek ist bewusst ohne Arduino-Abhängigkeiten geschrieben.
+ *****************************************************/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Ausgabefunktion: bekommt jeweils einen fertigen Block komprimierter Daten
+typedef void (*DeflateSink)(void* ctx, const uint8_t* data, size_t len);
+
+// Fortlaufende CRC-32 (Startwert 0), kompatibel zu gzip und ZIP
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len);
+
+class DeflateEncoder {
+public:
+  static const size_t WINDOW_SIZE = 4096;   // LZ77-Fenster (max. Distanz)
+  static const size_t HASH_SIZE   = 1024;   // Einträge der Hash-Tabelle
+  static const size_t OUT_SIZE    = 512;    // Ausgabepuffer vor dem Sink
+
+  void begin(DeflateSink sink, void* ctx);
+  void write(const uint8_t* data, size_t len);
+  void finish();                            // Block abschließen und alles ausgeben
+
+  uint32_t bytesOut() const { return _bytesOut; }
+
+private:
+  static const size_t BUF_SIZE  = 2 * WINDOW_SIZE;
+  static const size_t MIN_MATCH = 3;
+  static const size_t MAX_MATCH = 258;
+
+  void compress(size_t limit);              // verarbeitet _buf bis limit
+  void slide();
+  void putBits(uint32_t value, uint8_t count);
+  void putHuffman(uint16_t code, uint8_t len);
+  void putLiteral(uint8_t lit);
+  void putMatch(size_t length, size_t distance);
+  void flushOut();
+
+  DeflateSink _sink = nullptr;
+  void*       _ctx  = nullptr;
+
+  uint8_t  _buf[BUF_SIZE];                  // Fenster + Vorschau
+  uint16_t _head[HASH_SIZE];                // letzte Position je Hash (+1, 0 = leer)
+  size_t   _pos = 0;                        // nächstes zu kodierendes Byte
+  size_t   _end = 0;                        // Füllstand von _buf
+
+  uint32_t _bitBuf = 0;
+  uint8_t  _bitCount = 0;
+  uint8_t  _out[OUT_SIZE];
+  size_t   _outLen = 0;
+  uint32_t _bytesOut = 0;
+};
+
+class GzipWriter {
+public:
+  void begin(DeflateSink sink, void* ctx, uint32_t mtime = 0);
+  void write(const uint8_t* data, size_t len);
+  void finish();
+
+private:
+  DeflateEncoder _deflate;
+  DeflateSink _sink = nullptr;
+  void*       _ctx  = nullptr;
+  uint32_t _crc  = 0;
+  uint32_t _size = 0;
+};
+
+class ZipWriter {
+public:
+  static const uint8_t NAME_LEN = 40;
+
+  ~ZipWriter();
+
+  // Platz für maxEntries Einträge im Zentralverzeichnis (je 60 Byte, vorher zählen).
+  // deflate = false speichert die Daten unkomprimiert ("store"). false = zu wenig Speicher
+  bool begin(DeflateSink sink, void* ctx, uint16_t maxEntries, bool deflate = true);
+  bool beginEntry(const char* name, uint32_t unixTime);   // false, wenn maxEntries erreicht ist
+  void write(const uint8_t* data, size_t len);
+  void endEntry();
+  void finish();                            // Zentralverzeichnis schreiben
+
+private:
+  struct Entry {
+    char     name[NAME_LEN];
+    uint16_t dosTime;
+    uint16_t dosDate;
+    uint32_t crc;
+    uint32_t compSize;
+    uint32_t size;
+    uint32_t offset;
+  };
+
+  static void countingSink(void* ctx, const uint8_t* data, size_t len);
+  void emit(const uint8_t* data, size_t len);
+
+  DeflateEncoder _deflate;
+  DeflateSink _sink = nullptr;
+  void*       _ctx  = nullptr;
+  bool     _useDeflate = true;
+  bool     _inEntry = false;
+  Entry*   _entries = nullptr;
+  uint16_t _maxEntries = 0;
+  uint16_t _count = 0;
+  uint32_t _offset = 0;                     // bisher ausgegebene Bytes
+  uint32_t _entryStart = 0;
+};
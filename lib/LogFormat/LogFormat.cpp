@@ -0,0 +1,170 @@
+/*****************************************************
+ * LogFormat.cpp – Schreiben und Einlesen der CSV-Logzeilen
+ *
+ * Der Parser arbeitet ohne locale- und stdio-Aufrufe auf festen Positionen
+ * bzw. einfachen Ziffernschleifen, damit das Host-Werkzeug mehrere hundert
+ * MB/s pro Kern schafft.
+ *****************************************************/
+#include "LogFormat.h"
+
+#include <stdio.h>
+
+static inline bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+// Liest genau n Ziffern als Ganzzahl
+static bool readDigits(const char* s, size_t n, int& out) {
+  int v = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (!isDigit(s[i])) return false;
+    v = v * 10 + (s[i] - '0');
+  }
+  out = v;
+  return true;
+}
+
+size_t parseLogTimestamp(const char* s, size_t len, time_t& out, LogTimeCache* cache) {
+  // 0123456789012345678
+  // YYYY-MM-DD hh:mm:ss
+  if (len < 19 || s[4] != '-' || s[7] != '-' || s[10] != ' ' || s[13] != ':' || s[16] != ':') return 0;
+  struct tm t = {};
+  int year, mon;
+  if (!readDigits(s, 4, year) || !readDigits(s + 5, 2, mon) || !readDigits(s + 8, 2, t.tm_mday) ||
+      !readDigits(s + 11, 2, t.tm_hour) || !readDigits(s + 14, 2, t.tm_min) || !readDigits(s + 17, 2, t.tm_sec)) {
+    return 0;
+  }
+  if (t.tm_min > 59 || t.tm_sec > 60) return 0;
+
+  // Sommer-/Winterzeit wechselt nur zur vollen Stunde: pro Stunde genügt ein mktime()
+  int32_t hourKey = ((year * 100 + mon) * 100 + t.tm_mday) * 100 + t.tm_hour;
+  if (!cache || cache->hourKey != hourKey) {
+    struct tm h = t;
+    h.tm_year = year - 1900;
+    h.tm_mon = mon - 1;
+    h.tm_min = 0;
+    h.tm_sec = 0;
+    h.tm_isdst = -1;
+    time_t start = mktime(&h);
+    if (!cache) {
+      out = start + t.tm_min * 60 + t.tm_sec;
+      return 19;
+    }
+    cache->hourKey = hourKey;
+    cache->hourStart = start;
+  }
+  out = cache->hourStart + t.tm_min * 60 + t.tm_sec;
+  return 19;
+}
+
+// Gemeinsamer Kern: Mantisse (max. 18 Ziffern) und Zehnerexponent
+static size_t parseDecimal(const char* s, size_t len, bool& neg, uint64_t& mant, int& scale) {
+  size_t i = 0;
+  neg = false;
+  if (i < len && (s[i] == '-' || s[i] == '+')) {
+    neg = s[i] == '-';
+    i++;
+  }
+  mant = 0;
+  scale = 0;
+  int digits = 0;
+  int seen = 0;
+  while (i < len && isDigit(s[i])) {
+    if (digits < 18) { mant = mant * 10 + (s[i] - '0'); if (mant) digits++; }
+    else             scale++;
+    seen++;
+    i++;
+  }
+  if (i < len && (s[i] == ',' || s[i] == '.')) {
+    i++;
+    while (i < len && isDigit(s[i])) {
+      if (digits < 18) { mant = mant * 10 + (s[i] - '0'); if (mant) digits++; scale--; }
+      seen++;
+      i++;
+    }
+  }
+  return seen ? i : 0;
+}
+
+static const double POW10[19] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+  1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+};
+
+size_t parseGermanDouble(const char* s, size_t len, double& out) {
+  bool neg;
+  uint64_t mant;
+  int scale;
+  size_t n = parseDecimal(s, len, neg, mant, scale);
+  if (n == 0) return 0;
+  double v = (double)mant;
+  if (scale < 0)      v /= POW10[scale >= -18 ? -scale : 18];
+  else if (scale > 0) v *= POW10[scale <= 18 ? scale : 18];
+  out = neg ? -v : v;
+  return n;
+}
+
+size_t parseGermanFloat(const char* s, size_t len, float& out) {
+  double v;
+  size_t n = parseGermanDouble(s, len, v);
+  if (n) out = (float)v;
+  return n;
+}
+
+bool parseLogRow(const char* line, size_t len, LogRow& row, LogTimeCache* cache) {
+  size_t pos = parseLogTimestamp(line, len, row.timestamp, cache);
+  if (pos == 0 || pos >= len || line[pos] != LOG_SEPARATOR) return false;
+  pos++;
+
+  size_t start = pos;
+  row.runtime = 0;
+  while (pos < len && isDigit(line[pos])) {
+    row.runtime = row.runtime * 10 + (line[pos] - '0');
+    pos++;
+  }
+  if (pos == start) return false;
+
+  float values[8];
+  for (uint8_t i = 0; i < 8; i++) {
+    if (pos >= len || line[pos] != LOG_SEPARATOR) return false;
+    pos++;
+    size_t n = (i < 6) ? parseGermanFloat(line + pos, len - pos, values[i])
+                       : parseGermanDouble(line + pos, len - pos, row.cumulative[i - 6]);
+    if (n == 0) return false;
+    pos += n;
+  }
+  for (uint8_t i = 0; i < 4; i++) row.pressure[i] = values[i];
+  row.flow[0] = values[4];
+  row.flow[1] = values[5];
+  return true;
+}
+
+// Hängt einen Wert mit festen Nachkommastellen und Dezimalkomma an
+static size_t putFixed(char* buf, size_t size, double v, int decimals, char end) {
+  int n = snprintf(buf, size, "%.*f%c", decimals, v, end);
+  if (n < 0 || (size_t)n >= size) return 0;
+  for (int i = 0; i < n; i++) {
+    if (buf[i] == '.') {
+      buf[i] = ',';
+      break;
+    }
+  }
+  return (size_t)n;
+}
+
+size_t formatLogRow(const LogRow& row, char* buf, size_t size) {
+  struct tm t;
+  localtime_r(&row.timestamp, &t);
+  int n = snprintf(buf, size, "%04d-%02d-%02d %02d:%02d:%02d;%lu;",
+                   t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec,
+                   (unsigned long)row.runtime);
+  if (n < 0 || (size_t)n >= size) return 0;
+  size_t pos = (size_t)n;
+
+  for (uint8_t i = 0; i < 4; i++) pos += putFixed(buf + pos, size - pos, row.pressure[i], 3, LOG_SEPARATOR);
+  pos += putFixed(buf + pos, size - pos, row.flow[0], 2, LOG_SEPARATOR);
+  pos += putFixed(buf + pos, size - pos, row.flow[1], 2, LOG_SEPARATOR);
+  pos += putFixed(buf + pos, size - pos, row.cumulative[0], 2, LOG_SEPARATOR);
+  pos += putFixed(buf + pos, size - pos, row.cumulative[1], 2, '\n');
+  return pos;
+}
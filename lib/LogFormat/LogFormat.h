@@ -0,0 +1,67 @@
+/*****************************************************
+ * LogFormat.h – Aufbau der Logdateien (*_Rohdaten.csv) und des Zeitindex
+ *
+ * CSV-Zeile (Semikolon-getrennt, Dezimalkomma):
+ *   Zeitstempel;Laufzeit (s);Druck1..4 (bar);FlowRate1..2 (L/min);CumulativeFlow1..2 (L)
+ *
+ * Firmware (logData) und das Host-Werkzeug tools/logtool verwenden beide diese
+ * Definitionen, damit Schreiben und Einlesen nicht auseinanderlaufen.
+ *
+ * Zu jeder Logdatei schreibt der Rekorder einen dünnen Index (*_Rohdaten.idx):
+ * alle LOG_INDEX_EVERY Zeilen einen LogIndexEntry mit Zeitstempel und
+ * Byte-Offset der Zeile. Damit lässt sich ein Zeitfenster per binärer Suche
+ * anspringen, ohne die ganze Datei zu lesen.
+ *****************************************************/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#define LOG_SEPARATOR    ';'
+#define LOG_INDEX_EVERY  60      // ein Indexeintrag pro 60 Zeilen (= 1 Minute bei 1 Hz)
+#define LOG_COLUMNS      10
+#define LOG_ROW_MAX      160     // Puffergröße für eine formatierte Zeile
+
+// Zeitzone der Zeitstempel: Berlin, CET (UTC+1) im Winter, CEST (UTC+2) im Sommer.
+// Die Firmware schreibt Ortszeit; wer die Logs einliest, muss dieselbe Zone setzen (TZ + tzset()).
+#define LOG_TIMEZONE     "CET-1CEST,M3.5.0/2,M10.5.0/3"
+
+// Kopfzeile, die beim Start einer Aufnahme geschrieben wird
+#define LOG_CSV_HEADER "Zeitstempel;Laufzeit (s);Pressure1 (bar);Pressure2 (bar);Pressure3 (bar);Pressure4 (bar);" \
+                       "FlowRate1 (L/min);FlowRate2 (L/min);CumulativeFlow1 (L);CumulativeFlow2 (L)\n"
+
+// Ein Eintrag im Zeitindex (8 Byte, Little Endian wie auf dem ESP32)
+struct LogIndexEntry {
+  uint32_t timestamp;    // Unix-Zeit der ersten Zeile des Blocks
+  uint32_t offset;       // Byte-Offset dieser Zeile in der CSV-Datei
+};
+
+// Eine vollständig eingelesene CSV-Zeile
+struct LogRow {
+  time_t   timestamp;
+  uint32_t runtime;      // Laufzeit seit Start der Aufnahme (s)
+  float    pressure[4];  // bar
+  float    flow[2];      // L/min
+  double   cumulative[2];// L (double, damit große Summen genau bleiben)
+};
+
+// Merkt sich die Umrechnung der zuletzt gelesenen Stunde, damit mktime() nicht für jede Zeile läuft.
+// Jeder Thread braucht einen eigenen Cache.
+struct LogTimeCache {
+  int32_t hourKey = -1;  // YYYYMMDDhh der zwischengespeicherten Stunde
+  time_t  hourStart = 0; // Unix-Zeit von hh:00:00
+};
+
+// "YYYY-MM-DD hh:mm:ss" (lokale Zeit) => Unix-Zeit. Gibt die Anzahl gelesener Zeichen zurück (0 = Fehler).
+size_t parseLogTimestamp(const char* s, size_t len, time_t& out, LogTimeCache* cache = nullptr);
+
+// Zahl mit Dezimalkomma oder -punkt ("1,234" / "-0.5"). Gibt die Anzahl gelesener Zeichen zurück.
+size_t parseGermanFloat(const char* s, size_t len, float& out);
+size_t parseGermanDouble(const char* s, size_t len, double& out);
+
+// Komplette Zeile (ohne Zeilenende) einlesen; false bei Kopfzeile oder Formatfehler
+bool parseLogRow(const char* line, size_t len, LogRow& row, LogTimeCache* cache = nullptr);
+
+// Formatiert eine Zeile inkl. "\n" im Logformat (Dezimalkomma). Gibt die Länge zurück.
+size_t formatLogRow(const LogRow& row, char* buf, size_t size);
@@ -27,9 +27,14 @@
 #include <SPIFFS.h>           // SPIFFS (Dateisystem auf dem ESP32)
 #include <time.h>             // Zeitfunktionen (für NTP und Zeitstempel)
 #include <math.h>             // Für isnan()
+#include <new>                // std::nothrow für große Puffer auf dem Heap
+#include <esp_system.h>       // esp_reset_reason() für den Warmstart
+#include <esp_attr.h>         // __NOINIT_ATTR (RAM-Bereich, der beim Neustart erhalten bleibt)
 #include <ArduinoJson.h>      // JSON-Verarbeitung
 #include <HTTPClient.h>       // HTTP-Client für Anfragen an die API
 #include <Preferences.h>      // Einfache Speicherung von Einstellungen
+#include <DeflateStream.h>    // gzip/ZIP-Export direkt auf dem ESP32 (lib/DeflateStream)
+#include <LogFormat.h>        // Aufbau der CSV-Logs und des Zeitindex (lib/LogFormat)
 bool timeSet = false;         // Variable, um zu überprüfen, ob die Zeit gesetzt wurde
 
 /* ====================================================
@@ -48,12 +53,6 @@ Adafruit_ADS1115 ads;                          // Objekt für den ADS1115
 #define I2C_SDA 21                            // I²C SDA-Pin (Datenleitung)
 #define I2C_SCL 22                            // I²C SCL-Pin (Taktleitung)
 #define ADS_VOLTAGE_PER_BIT 0.000125          // Umrechnungsfaktor: 0.000125 V pro Bit
-// --- deutsches format der float-Zahlen
-String toGermanFloatString(float f, unsigned int decimals = 2) {  // Ändere uint8_t zu unsigned int
-  String s = String(f, decimals);
-  s.replace('.', ',');
-  return s;
-}
 // ---  In-Memory-Datenpuffer für Messwerte der letzten 10 Minuten ---
 #define BUFFER_SIZE 600  // 600 Einträge = 10 Minuten bei 1 Hz
 
@@ -64,7 +63,8 @@ struct SensorData {
   float flowRate2;       // Durchflusswert Sensor 2
 };
 
-SensorData dataBuffer[BUFFER_SIZE];  // Puffer für die letzten 10 Minuten
+// __NOINIT_ATTR: wird beim Neustart nicht gelöscht (siehe Warmstart-Zustand unten)
+__NOINIT_ATTR SensorData dataBuffer[BUFFER_SIZE];  // Puffer für die letzten 10 Minuten
 int bufferIndex = 0;                   // Aktueller Index im Puffer
 
 // ---  In-Memory-Datenpuffer für Messwerte der geloggten Daten ---
@@ -77,7 +77,7 @@ struct LoggingData {
   float flow2;
 };
 
-LoggingData loggingBuffer[LOGGING_BUFFER_SIZE];
+__NOINIT_ATTR LoggingData loggingBuffer[LOGGING_BUFFER_SIZE];
 int loggingIndex = 0;
 
 /* ----- Kalibrierungsvariablen für Drucksensoren -----
@@ -107,25 +107,100 @@ uint32_t lastPulseCount1 = 0;                  // Letzter Zählerstand Sensor 1
 uint32_t lastPulseCount2 = 0;                  // Letzter Zählerstand Sensor 2
 float flowRate1 = 0.0;                         // Momentaner Durchfluss Sensor 1 (L/min)
 float flowRate2 = 0.0;                         // Momentaner Durchfluss Sensor 2 (L/min)
-float cumulativeFlow1 = 0.0;                   // Kumulativer Durchfluss Sensor 1 (L)
-float cumulativeFlow2 = 0.0;                   // Kumulativer Durchfluss Sensor 2 (L)
+#define FLOW_PULSES_PER_LITER 660.0            // 11 Hz pro L/min * 60 s für YF-B2 (98.0 * 60 für YF-S401; 7.5 * 60 für YF-S201)
+uint64_t totalPulses1 = 0;                     // Exakte Impulssumme Sensor 1 seit dem letzten Zurücksetzen
+uint64_t totalPulses2 = 0;                     // Exakte Impulssumme Sensor 2 seit dem letzten Zurücksetzen
+
+// Kumulativer Durchfluss in Litern – Umrechnung erst bei der Ausgabe, damit keine Impulse verloren gehen
+double cumulativeLiters(uint64_t pulses) {
+  return pulses / FLOW_PULSES_PER_LITER;
+}
+
+/* ----- Totalisator-Persistenz (Journal im NVS) -----
+   Die Impulssummen überleben Neustarts und Spannungsausfälle. Statt jedes Mal
+   beide 64-Bit-Summen zu schreiben, wird nur der Zuwachs seit dem letzten Commit
+   in einen von mehreren rotierenden Journal-Slots geschrieben. Nach einem Umlauf
+   wird der Basisstand neu gesichert; beim Start werden Basis + Journal addiert.
+*/
+#define TOTALIZER_COMMIT_MS 20000              // Höchstens 3 Schreibvorgänge pro Minute
+#define TOTALIZER_SLOTS 8                      // Journal-Slots "j1".."j7" + Basisstand
+Preferences totalizerPrefs;                    // NVS-Namensraum "totalizer"
+
+struct TotalizerBase {
+  uint64_t pulses[2];                          // Vollständige Impulssummen
+  uint32_t seq;                                // Sequenznummer dieses Standes
+};
+
+struct TotalizerDelta {
+  uint32_t seq;                                // Sequenznummer (Slot = seq % TOTALIZER_SLOTS)
+  uint32_t delta[2];                           // Zuwachs seit dem vorherigen Commit
+};
+
+uint32_t totalizerSeq = 0;                     // Sequenznummer des letzten Commits
+uint64_t committedPulses[2] = {0, 0};          // Impulssummen beim letzten Commit
+unsigned long lastTotalizerCommit = 0;         // Zeitpunkt des letzten Commits (millis)
 
 /* ----- Logging Konfiguration ----- */
 unsigned long startRecordingMillis = 0; 
 bool recording = false;                        // Datenlogging: Ein (true) / Aus (false)
 String logFileName;                            // Dateiname für Logdaten im SPIFFS
-String getFileTimestamp() {
-  time_t now = time(nullptr);
+uint32_t logRowCount = 0;                      // Geschriebene Zeilen der aktuellen Aufnahme (für den Zeitindex)
+#define ZIP_MAX_FILES 128                      // max. Logdateien pro /downloadzip (je 60 Byte RAM im ZipWriter)
+// Lokale Zeit als Text, Standard "YYYY-MM-DD hh:mm:ss" (20 Byte inkl. Nullbyte).
+// strftime schreibt nie über size hinaus; passt der Text nicht, bleibt buf leer.
+size_t formatTimestamp(time_t t, char* buf, size_t size, const char* format = "%Y-%m-%d %H:%M:%S") {
   struct tm timeinfo;
-  localtime_r(&now, &timeinfo);
-  char buf[30];
+  localtime_r(&t, &timeinfo);
+  size_t len = strftime(buf, size, format, &timeinfo);
+  if (len == 0 && size > 0) buf[0] = '\0';
+  return len;
+}
+
+String getFileTimestamp() {
+  char buf[24];
   // Format z.B. TT-MM-YYYY_hh-mm
-  sprintf(buf, "%02d-%02d-%04d_%02d-%02d",
-          timeinfo.tm_mday, timeinfo.tm_mon + 1, timeinfo.tm_year + 1900,
-          timeinfo.tm_hour, timeinfo.tm_min);
+  formatTimestamp(time(nullptr), buf, sizeof(buf), "%d-%m-%Y_%H-%M");
   return String(buf);
 }
 
+/* ----- Warmstart-Zustand (No-Init-RAM) -----
+   Nach einem Watchdog-Reset, Absturz oder OTA-Neustart bleibt der No-Init-RAM erhalten.
+   Dort liegen die beiden Ringpuffer und dieser Kopf mit Sitzung, Uhrzeit und
+   Laufzeit-Kalibrierung. Nur wenn Magic, Layout und CRC stimmen, wird weitergemacht;
+   nach Power-On/Brown-out wird alles verworfen.
+   Die Ringpuffer sind in Blöcke zu RETAINED_BLOCK Einträgen geteilt, jeder mit eigener
+   CRC im Kopf. Pro Messzyklus wird nur der gerade beschriebene Block neu berechnet;
+   beim Warmstart werden beschädigte Blöcke geleert statt übernommen.
+*/
+#define RETAINED_MAGIC   0x464C5752            // "FLWR"
+#define RETAINED_LAYOUT  (sizeof(RetainedState) + sizeof(dataBuffer) + sizeof(loggingBuffer))
+#define RETAINED_BLOCK   20                    // Einträge je CRC-Block
+#define DATA_BLOCKS      ((BUFFER_SIZE + RETAINED_BLOCK - 1) / RETAINED_BLOCK)
+#define LOGGING_BLOCKS   ((LOGGING_BUFFER_SIZE + RETAINED_BLOCK - 1) / RETAINED_BLOCK)
+
+struct RetainedState {
+  uint32_t magic;
+  uint32_t layout;                             // Größe aller gesicherten Bereiche (erkennt geänderte Firmware)
+  int32_t  bufferIndex;                        // Schreibposition dataBuffer
+  int32_t  loggingIndex;                       // Schreibposition loggingBuffer
+  bool     recording;                          // Aufnahme lief
+  char     logFileName[32];                    // Aktuelle Logdatei
+  uint32_t logRowCount;                        // Bereits geschriebene Zeilen (Zeitindex)
+  uint32_t recordingMillis;                    // Bisherige Aufnahmedauer
+  bool     timeSet;                            // Uhrzeit wurde per /setTime gesetzt
+  int64_t  wallClock;                          // Unix-Zeit beim letzten Sichern
+  float    vMin[4];                            // Laufzeit-Kalibrierung (calibrateSensorVmin)
+  float    vMax[4];
+  uint64_t totalPulses[2];                     // Exakte Impulssummen (genauer als der letzte NVS-Commit)
+  uint32_t totalizerSeq;                       // Zugehörige NVS-Sequenznummer
+  uint32_t dataCrc[DATA_BLOCKS];               // CRC-32 je Block von dataBuffer
+  uint32_t loggingCrc[LOGGING_BLOCKS];         // CRC-32 je Block von loggingBuffer
+  uint32_t crc;                                // CRC-32 über alle Felder davor
+};
+
+__NOINIT_ATTR RetainedState retained;
+bool warmRestart = false;                      // true, wenn der Zustand beim Start übernommen wurde
+
 /* ----- Zeitsteuerung ----- */
 unsigned long previousMillis = 0;              // Hilfsvariable für Zeitmessung in der Loop
 const unsigned long interval = 1000;           // Messintervall (1 Sekunde)
@@ -133,6 +208,284 @@ const unsigned long interval = 1000;           // Messintervall (1 Sekunde)
 /* ----- Webserver Konfiguration ----- */
 WebServer server(80);                          // Webserver, der auf Port 80 lauscht
 
+/* ----- Letzter Messwert und Antwort-Cache -----
+   Jeder Messzyklus erhöht sampleSeq. Als ETag dient die Sample-Sequenz (plus
+   stateVersion für Änderungen außerhalb des Messzyklus, z.B. Recording an/aus);
+   aktuelle Clients bekommen 304 ohne Body.
+   Nur kleine JSON-Antworten (Sensorwerte, Kennwerte) werden höchstens einmal pro
+   Messzyklus aufgebaut und aus dem Cache geliefert. Die Diagrammdaten (bis ~130 KB)
+   werden nicht gespeichert, sondern bei jeder Anfrage in Stücken gestreamt.
+*/
+uint32_t sampleSeq = 0;                        // Zähler der Messzyklen
+uint32_t stateVersion = 0;                     // Zähler für Zustandsänderungen zwischen zwei Messzyklen
+time_t latestSampleTime = 0;                   // Zeitpunkt des letzten Messwerts
+float latestPressures[4] = {NAN, NAN, NAN, NAN}; // Druckwerte des letzten Messzyklus (bar, NAN = ohne ADS1115)
+
+struct ResponseCache {
+  uint32_t seq;                                // sampleSeq beim Aufbau
+  uint32_t version;                            // stateVersion beim Aufbau
+  String*  body;                               // nullptr = noch nicht aufgebaut
+};
+
+ResponseCache sensorwerteCache = {0, 0, nullptr};
+ResponseCache statsCache = {0, 0, nullptr};
+
+/* ----- Telemetrie-Uplink (Station-Modus, Store-and-Forward) -----
+   Optional verbindet sich die Station zusätzlich zum eigenen Access Point (AP+STA)
+   mit einem WLAN und schickt die Messwerte paketweise per HTTP POST an einen
+   Collector. Der Messzyklus füllt nur ein RAM-Paket und übergibt es per Queue;
+   der Uplink-Task schreibt es in den Outbox-Ordner im SPIFFS und sendet die
+   Pakete in Reihenfolge, sobald eine Verbindung besteht. Bei Fehlern wird mit
+   wachsendem Abstand erneut versucht; vom Collector abgelehnte Pakete (4xx)
+   werden nach UPLINK_MAX_RETRIES verworfen.
+   uplinkConfig wird in loop() (Kern 1) geändert und vom Uplink-Task (Kern 0)
+   gelesen: Änderungen und die Kopie des Tasks nur unter uplinkConfigMutex.
+   Derselbe Mutex schützt die Outbox-Zähler uplinkHeadSeq/uplinkNextSeq, die der
+   Task schreibt und /api/uplink liest.
+*/
+#define UPLINK_MAX_SAMPLES   120               // max. Messwerte pro Paket (2 Minuten bei 1 Hz)
+#define UPLINK_OUTBOX_MAX    256               // max. Pakete im Outbox-Ordner, danach wird das älteste verworfen
+#define UPLINK_MAX_RETRIES   10                // Versuche für ein vom Collector abgelehntes Paket
+#define UPLINK_BACKOFF_MAX_S 300               // max. Wartezeit zwischen zwei Versuchen (s)
+
+struct UplinkConfig {
+  bool     enabled;                            // AP+STA und Uplink aktiv
+  String   staSsid;                            // WLAN, in das sich die Station einbucht
+  String   staPassword;
+  String   collectorUrl;                       // z.B. http://192.168.178.10:8080/ingest
+  String   stationId;                          // Kennung der Station beim Collector
+  uint16_t batchSeconds;                       // Messwerte pro Paket
+  bool     gzip;                               // Pakete gzip-komprimiert speichern und senden
+};
+
+// Kompakte Kodierung eines Messwerts (14 Byte, Little Endian)
+struct __attribute__((packed)) UplinkSample {
+  uint16_t dt;                                 // Sekunden seit firstTime
+  int16_t  pressure[4];                        // mbar
+  uint16_t flow[2];                            // 0,01 L/min
+};
+
+struct __attribute__((packed)) UplinkBatchHeader {
+  char     magic[4];                           // "FLB1"
+  uint32_t seq;                                // fortlaufende Paketnummer (für Reihenfolge/Duplikate)
+  uint32_t firstTime;                          // Unix-Zeit des ersten Messwerts
+  uint16_t count;                              // Anzahl Messwerte
+  uint16_t flags;                              // reserviert
+};
+
+struct UplinkBatch {
+  UplinkBatchHeader header;
+  UplinkSample samples[UPLINK_MAX_SAMPLES];
+};
+
+UplinkConfig uplinkConfig = {false, "", "", "", "", 60, true};
+SemaphoreHandle_t uplinkConfigMutex = nullptr; // schützt uplinkConfig und die Outbox-Zähler
+Preferences uplinkPrefs;                       // NVS-Namensraum "uplink"
+QueueHandle_t uplinkQueue = nullptr;           // fertige Pakete: Messzyklus -> Uplink-Task
+TaskHandle_t uplinkTaskHandle = nullptr;
+UplinkBatch uplinkBatch;                       // Paket, das gerade im Messzyklus gefüllt wird
+uint32_t uplinkNextSeq = 0;                    // nächste zu vergebende Paketnummer
+uint32_t uplinkHeadSeq = 0;                    // ältestes Paket im Outbox-Ordner
+volatile uint32_t uplinkSent = 0;              // erfolgreich gesendete Pakete
+volatile uint32_t uplinkDropped = 0;           // verworfene Pakete (Queue voll, Outbox voll, abgelehnt)
+volatile int uplinkLastStatus = 0;             // letzter HTTP-Status bzw. Fehlercode
+volatile uint32_t uplinkBackoffMs = 0;         // aktuelle Wartezeit nach einem Fehlschlag (0 = keine)
+
+/* ----- Ereigniserkennung (Regeln im Messzyklus) -----
+   Eine feste Regeltabelle wird in jedem Messzyklus direkt nach dem Auslesen der
+   Sensoren geprüft – vor Totalisator, Logdatei und Uplink, die auf den Flash
+   warten können. Je Regel gibt es nur einen kleinen Zustand (aktiv, Entprellzähler),
+   für Änderungsraten einen Verlauf fester Länge je Kanal.
+   Kanäle: 0..3 = Druck 1..4 (bar), 4..5 = Durchfluss 1..2 (L/min).
+   Ausgelöste und beendete Ereignisse kommen mit Zeitstempel und gemessener Latenz
+   (Beginn des Messzyklus bis Ereignis erfasst) ins Ereignisprotokoll; der
+   Alarmausgang schaltet im selben Messzyklus. Geöffnete Webseiten bekommen neue
+   Ereignisse noch im selben Messzyklus per Server-Sent Events (/api/events/stream)
+   zugeschickt; ohne Stream erfahren sie es über die Ereignisnummer in /api/sensorwerte.
+*/
+#define EVENT_RULES_MAX     8                  // Größe der Regeltabelle
+#define EVENT_LOG_SIZE      32                 // Ereignisse im RAM (Ringpuffer)
+#define EVENT_CHANNELS      6                  // 4x Druck + 2x Durchfluss
+#define EVENT_RATE_WINDOW   30                 // max. Zeitfenster für Änderungsraten (Messzyklen)
+#define EVENT_OUTPUT_PIN    25                 // Alarmausgang: HIGH, solange eine Regel mit "output" aktiv ist
+#define EVENT_FILE          "/events.csv"      // Ereignisprotokoll im SPIFFS
+#define EVENT_FILE_MAX      32768              // danach wird es nach EVENT_FILE_OLD verschoben
+#define EVENT_FILE_OLD      "/events_alt.csv"
+#define EVENT_STREAM_CLIENTS 3                 // gleichzeitige SSE-Verbindungen (je ein Socket)
+#define EVENT_STREAM_PING_MS 15000             // Kommentarzeile, damit tote Verbindungen auffallen
+
+enum EventRuleType : uint8_t {
+  RULE_ABOVE = 0,                              // Kanal a über threshold
+  RULE_BELOW,                                  // Kanal a unter threshold
+  RULE_RISE,                                   // Kanal a steigt um mehr als threshold pro Sekunde (über window Zyklen)
+  RULE_DROP,                                   // Kanal a fällt um mehr als threshold pro Sekunde (über window Zyklen)
+  RULE_DIFF,                                   // Kanal a minus Kanal b über threshold
+  RULE_FLOW_NO_PRESSURE,                       // Kanal a (Durchfluss) über threshold, Kanal b (Druck) unter threshold2
+  RULE_TYPE_COUNT
+};
+
+struct EventRule {
+  bool     enabled;
+  uint8_t  type;                               // EventRuleType
+  uint8_t  a;                                  // Kanal
+  uint8_t  b;                                  // zweiter Kanal (RULE_DIFF, RULE_FLOW_NO_PRESSURE)
+  uint8_t  hold;                               // Messzyklen, die eine Bedingung anstehen muss (Entprellung)
+  uint8_t  window;                             // Zeitfenster für RULE_RISE/RULE_DROP (Messzyklen)
+  bool     output;                             // Alarmausgang schalten
+  float    threshold;
+  float    threshold2;                         // zweite Schwelle (RULE_FLOW_NO_PRESSURE: Druck in bar)
+  float    hysteresis;                         // Abstand zur Schwelle, ab dem das Ereignis endet
+  char     name[24];                           // Anzeigename
+};
+
+struct EventRuleState {
+  bool     active;
+  uint8_t  count;                              // Messzyklen in Folge, in denen Auslösen/Beenden ansteht
+};
+
+struct EventRecord {
+  uint32_t id;                                 // fortlaufend ab 1
+  time_t   time;                               // Zeitpunkt des Messwerts
+  uint8_t  rule;
+  bool     active;                             // true = ausgelöst, false = beendet
+  float    value;                              // ausgewerteter Wert (Messwert, Rate oder Differenz)
+  uint32_t latencyUs;                          // Beginn des Messzyklus bis Ereignis erfasst (inkl. ADC)
+  uint32_t deliveryMs;                         // Messzyklus bis zum ersten Push an einen Client (0 = nicht per Push)
+  unsigned long createdMillis;
+};
+
+EventRule eventRules[EVENT_RULES_MAX];
+EventRuleState eventState[EVENT_RULES_MAX];
+EventRecord eventLog[EVENT_LOG_SIZE];
+uint32_t eventLastId = 0;                      // Nummer des letzten Ereignisses
+uint32_t eventPersistedId = 0;                 // letztes Ereignis, das in EVENT_FILE steht
+uint8_t eventActiveMask = 0;                   // Bit r = Regel r aktiv
+float eventHistory[EVENT_CHANNELS][EVENT_RATE_WINDOW + 1];  // letzte Messwerte je Kanal (Ringpuffer)
+uint8_t eventHistoryIndex = 0;
+uint8_t eventHistoryCount = 0;
+uint32_t eventEvalUs = 0;                      // Dauer der letzten Auswertung
+uint32_t eventEvalUsMax = 0;
+uint32_t eventLatencyUsMax = 0;                // größte gemessene Latenz Messzyklus -> Ereignis
+uint32_t eventDeliveryMsMax = 0;               // größte gemessene Latenz Messzyklus -> Client (Push)
+WiFiClient eventStreamClients[EVENT_STREAM_CLIENTS];  // offene SSE-Verbindungen
+uint32_t eventPushedId = 0;                    // letztes Ereignis, das an die Streams geschickt wurde
+unsigned long eventStreamLastWrite = 0;
+Preferences eventPrefs;                        // NVS-Namensraum "events"
+
+/* ----- Kennwerte (laufend aktualisierte Statistik) -----
+   Je Kanal wird in jedem Messzyklus mit O(1) fortgeschrieben:
+     - Sitzung (seit Start der Aufnahme oder /resetStats): Mittelwert und Varianz
+       nach Welford, Min/Max und die Quantile p50/p90/p99 als P²-Schätzer
+       (5 Marker je Quantil, feste Größe, keine gespeicherten Messwerte)
+     - zwei gleitende Fenster über dataBuffer: Mittelwert/Varianz (Welford, der älteste
+       Wert wird wieder herausgerechnet) und Min/Max über monotone Deques mit
+       Positionen in dataBuffer. Die Längen (Standard 1 und 5 Minuten) werden per
+       POST /api/stats eingestellt und im NVS gespeichert; die Deques sind für
+       STATS_WINDOW_MAX Messzyklen ausgelegt.
+   Abgeleitete Kanäle: Druckdifferenz der Paare 1-2 und 3-4 und diese Differenz
+   pro Durchfluss der zugehörigen Leitung (bar pro L/min, erst ab STATS_PPF_MIN_FLOW).
+   /api/stats liefert alles als kleines JSON aus dem Antwort-Cache.
+*/
+#define STATS_CHANNELS      10                 // p1..p4, f1, f2, dp12, dp34, ppf1, ppf2
+#define STATS_WINDOWS       2                  // Anzahl gleitender Fenster
+#define STATS_WINDOW_MIN    10                 // kürzeste einstellbare Fensterlänge (Messzyklen)
+#define STATS_WINDOW_MAX    300                // längste einstellbare Fensterlänge (5 Minuten), muss kleiner als BUFFER_SIZE sein
+#define STATS_QUANTILES     3                  // p50, p90, p99
+#define STATS_PPF_MIN_FLOW  0.5f               // L/min; darunter ist Druck pro Durchfluss nicht aussagekräftig
+
+// P²-Schätzer eines Quantils (Jain/Chlamtac): 5 Marker, Positionen und Sollpositionen
+struct P2Quantile {
+  float    p;                                  // gesuchtes Quantil (0..1)
+  uint32_t count;                              // bisher eingegangene Werte
+  float    q[5];                               // Markerhöhen (bis count == 5: die sortierten Werte)
+  int32_t  n[5];                               // Markerpositionen
+  double   np[5];                              // Sollpositionen
+};
+
+struct SessionStats {
+  uint32_t   n;
+  double     mean;
+  double     m2;                               // Summe der quadrierten Abweichungen (Welford)
+  float      min;
+  float      max;
+  P2Quantile quantiles[STATS_QUANTILES];
+};
+
+// Ringpuffer mit Positionen in dataBuffer (höchstens N Einträge, da das Fenster N Messzyklen umfasst)
+template <uint16_t N>
+struct IndexDeque {
+  uint16_t pos[N];
+  uint16_t head;
+  uint16_t size;
+
+  uint16_t front() const { return pos[head]; }
+  uint16_t back() const { return pos[(head + size - 1) % N]; }
+  void popFront() { head = (head + 1) % N; size--; }
+  void popBack() { size--; }
+  void pushBack(uint16_t p) { pos[(head + size) % N] = p; size++; }
+};
+
+struct WindowStats {
+  uint16_t n;
+  double   mean;
+  double   m2;
+  IndexDeque<STATS_WINDOW_MAX> minQ;           // Werte aufsteigend, vorne das Minimum
+  IndexDeque<STATS_WINDOW_MAX> maxQ;           // Werte absteigend, vorne das Maximum
+};
+static_assert(STATS_WINDOW_MAX < BUFFER_SIZE, "Fenster muss kleiner als dataBuffer sein");
+
+const char* const statsChannelNames[STATS_CHANNELS] = {"p1", "p2", "p3", "p4", "f1", "f2", "dp12", "dp34", "ppf1", "ppf2"};
+const uint8_t statsChannelDecimals[STATS_CHANNELS] = {3, 3, 3, 3, 2, 2, 3, 3, 4, 4};
+const float statsQuantiles[STATS_QUANTILES] = {0.5f, 0.9f, 0.99f};
+
+SessionStats statsSession[STATS_CHANNELS];
+const uint16_t statsWindowDefaults[STATS_WINDOWS] = {60, 300};
+uint16_t statsWindowLen[STATS_WINDOWS];        // eingestellte Fensterlängen (Messzyklen), aufsteigend
+WindowStats statsWindows[STATS_WINDOWS][STATS_CHANNELS];
+Preferences statsPrefs;                        // NVS-Namensraum "stats"
+time_t statsSessionStart = 0;                  // Beginn der Sitzung (Unix-Zeit)
+
+/* ----- Start in Stufen und Zustand der Teilsysteme -----
+   setup() bringt zuerst WLAN und Webserver hoch, damit die Weboberfläche auch dann
+   erreichbar ist, wenn ein Teilsystem fehlt. SPIFFS wird in einem eigenen Task
+   eingehängt (ggf. formatiert), der ADS1115 in loop() mit wachsender Wartezeit erneut
+   gesucht. Solange er fehlt, läuft die Station ohne Druckwerte weiter.
+   /api/health zeigt den Zustand je Teilsystem und die Startzeiten.
+*/
+#define BOOT_BUDGET_MS      1000               // Ziel: Webserver spätestens so viele ms nach dem Reset bereit
+#define BOOT_RETRY_MIN_MS   500                // erste Wartezeit bis zum nächsten Versuch
+#define BOOT_RETRY_MAX_MS   30000              // Wartezeit verdoppelt sich bis höchstens hierhin
+
+enum SubsystemState { SUB_PENDING, SUB_OK, SUB_RETRY };
+enum SubsystemId { SUB_WIFI, SUB_HTTP, SUB_FS, SUB_ADC, SUB_FLOW, SUB_COUNT };
+
+struct Subsystem {
+  volatile SubsystemState state;
+  uint16_t attempts;                           // Versuche bisher
+  uint32_t readyMs;                            // millis() beim Erfolg
+  uint32_t retryMs;                            // aktuelle Wartezeit bis zum nächsten Versuch
+  uint32_t nextTryMs;                          // millis() des nächsten Versuchs
+  const char* error;                           // letzter Fehler (Klartext)
+};
+
+const char* const subsystemNames[SUB_COUNT] = {"wifi", "http", "fs", "adc", "flow"};
+Subsystem subsystems[SUB_COUNT];
+uint32_t bootFirstRequestMs = 0;               // millis() beim Eintreffen der ersten HTTP-Anfrage nach dem Start
+uint32_t bootFirstResponseMs = 0;              // millis(), nachdem deren Antwort gesendet war (0 = noch keine)
+TaskHandle_t fsTaskHandle = nullptr;
+
+// Wird vor allen Routen gefragt und merkt sich nur die erste Anfrage; deren Antwort
+// folgt im selben handleClient()-Aufruf, danach stempelt loop() bootFirstResponseMs.
+class FirstRequestProbe : public RequestHandler {
+public:
+  bool canHandle(HTTPMethod method, String uri) override {
+    (void)method;
+    (void)uri;
+    if (bootFirstRequestMs == 0) bootFirstRequestMs = millis() | 1;   // 0 bedeutet "noch keine"
+    return false;
+  }
+};
+
 /* ====================================================
  * 3. Funktionsprototypen (Vorwärtsdeklarationen)
  * ==================================================== */
@@ -141,6 +494,7 @@ WebServer server(80);                          // Webserver, der auf Port 80 lau
 float readPressureSensor(uint8_t channel);     // Liest den Drucksensor an einem Kanal und berechnet den Druck in bar
 void logData();                                // Schreibt Messdaten als CSV-Zeile in SPIFFS
 String getTimeString();                        // Gibt den aktuellen Zeitstempel als String zurück
+String indexFileName(const String& csvName);   // Dateiname des Zeitindex zu einer Logdatei
 
 // Interrupt-Service-Routinen für Durchflusssensoren
 void IRAM_ATTR flowSensor1ISR();               // ISR für Durchflusssensor 1 (FALLING-Edge)
@@ -150,6 +504,15 @@ void IRAM_ATTR flowSensor2ISR();               // ISR für Durchflusssensor 2 (F
 void loadCalibration();                        // Lädt Kalibrierungswerte aus dem EEPROM
 void saveCalibration();                        // Speichert Kalibrierungswerte ins EEPROM
 
+// Warmstart-Zustand im No-Init-RAM
+void restoreRetainedState();                   // Übernimmt Puffer/Sitzung/Uhrzeit nach einem Warmstart
+void saveRetainedState();                      // Aktualisiert Kopf + CRC (nach jedem Messzyklus)
+
+// Totalisator (kumulativer Durchfluss) im NVS
+void loadTotalizer();                          // Stellt die Impulssummen aus Basis + Journal wieder her
+void commitTotalizer();                        // Schreibt den Zuwachs seit dem letzten Commit
+void clearTotalizer();                         // Setzt die Impulssummen zurück (persistent)
+
 // Webserver-Handler (HTTP-Endpunkte)
 // Statische Dateien (Webseitendateien)
 void handleRoot();                             // Liefert index.html aus SPIFFS
@@ -160,7 +523,8 @@ void handleJS();                               // Liefert script.js aus SPIFFS
 void handleSensorwerte();                      // Liefert aktuelle Sensorwerte (JSON)
 void handleGetTime();                          // Liefert die aktuelle Zeit als Text
 void handleSetTime();                          // Setzt die Systemzeit (Parameter: t)
-void handleDownloadLog();                      // Ermöglicht das Herunterladen der Logdatei (CSV)
+void handleDownloadLog();                      // Ermöglicht das Herunterladen der Logdatei (CSV, Range, gzip)
+void handleDownloadZip();                      // Streamt mehrere Logdateien als ZIP-Archiv
 void handleToggleRecording();                  // Schaltet das Recording (Datenlogging) um
 void handleDeleteLog();                        // Löscht die Logdatei
 void handleClearCumulativeFlow();              // Setzt den kumulativen Durchfluss zurück
@@ -171,46 +535,93 @@ void handleChartsHtml();                       // Liefert die Charts-Seite
 void handleLast10Min();                        // Neu: Liefert Diagrammdaten der letzten 10 Minuten
 void handleFileRead();                         // Liefert statische Dateien aus SPIFFS
 void handleLoggingData();                      // Liefert die geloggten Daten als JSON
+void handleLogData();                          // Liefert ein Zeitfenster einer Logdatei (über den Zeitindex)
 void handleResetCalibration();                 // Setzt die Kalibrierungswerte zurück
 void handleGetCalibration();                   // Liefert die Kalibrierungswerte als JSON
+
+// Antwort-Cache (einmal pro Messzyklus aufgebaut) und ETag
+bool answerNotModified();                      // Setzt ETag/Cache-Control; true, wenn 304 gesendet wurde
+void sendCachedJson(ResponseCache& cache, String (*build)());  // ETag/304 oder Body aus dem Cache
+String buildSensorwerteJson();                 // Aktuelle Sensorwerte
+void sendChunkIfFull(String& chunk);           // Schickt den gesammelten Teil einer gestreamten Antwort ab 1 KB
+String jsonString(const String& text);         // Text als maskierter JSON-String
+
+// Telemetrie-Uplink
+void loadUplinkConfig();                       // Liest die Uplink-Einstellungen aus dem NVS
+void startUplink();                            // Startet STA-Verbindung, Queue und Uplink-Task
+void stopUplink();                             // Trennt die STA-Verbindung; der Uplink-Task beendet sich selbst
+void uplinkAddSample(time_t t, const float* pressures, float flow1, float flow2);  // Aus dem Messzyklus
+void uplinkTask(void* param);                  // Schreibt Pakete in die Outbox und sendet sie
+int uplinkSendHead(const UplinkConfig& config); // Sendet das älteste Paket der Outbox
+void handleGetUplink();                        // Liefert Uplink-Einstellungen und -Status (JSON)
+void handleSetUplink();                        // Übernimmt Uplink-Einstellungen (JSON)
+
+// Ereigniserkennung
+void loadEventRules();                         // Liest die Regeltabelle aus dem NVS
+void evaluateEvents(const float* values, uint32_t sampleStartUs);  // Aus dem Messzyklus, vor Flash/Netzwerk
+void persistEvents();                          // Hängt neue Ereignisse an EVENT_FILE an
+void pushEvents();                             // Schickt neue Ereignisse an die SSE-Verbindungen (aus dem Messzyklus)
+void handleGetEvents();                        // Liefert Ereignisse ab ?since=<id> und die Latenzen (JSON)
+void handleEventStream();                      // Öffnet eine SSE-Verbindung für neue Ereignisse
+void handleGetEventRules();                    // Liefert die Regeltabelle (JSON)
+void handleSetEventRule();                     // Übernimmt eine Regel (JSON)
+
+// Kennwerte
+void loadStatsWindows();                       // Liest die Fensterlängen aus dem NVS
+void resetSessionStats();                      // Beginnt eine neue Sitzung (Aufnahme-Start, /resetStats)
+void rebuildWindowStats();                     // Baut die gleitenden Fenster aus dataBuffer auf (Start/Warmstart)
+void updateStats(uint16_t pos);                // Aus dem Messzyklus, nachdem dataBuffer[pos] geschrieben wurde
+void handleStats();                            // Liefert die Kennwerte (JSON, gecacht)
+void handleSetStats();                         // Übernimmt die Fensterlängen (JSON)
+void handleResetStats();                       // Setzt die Sitzungs-Kennwerte zurück
+String buildStatsJson();
+
+// Start und Zustand der Teilsysteme
+void subsystemResult(SubsystemId id, bool ok, const char* error);  // Erfolg merken oder nächsten Versuch planen
+bool subsystemDue(SubsystemId id);             // true, wenn ein erneuter Versuch fällig ist
+void startAccessPoint();                       // WLAN-Access-Point (mit Uplink zusätzlich Station), ein Versuch
+void startADC();                               // Sucht den ADS1115 (ein Versuch, blockiert nicht)
+bool checkADC();                               // Antwortet der ADS1115 noch? Sonst wieder Wiederholversuche
+void fsTask(void* param);                      // Hängt das SPIFFS ein (ggf. mit Formatieren), bis es klappt
+void serviceSubsystems();                      // Aus loop(): fällige Versuche für WLAN und ADC
+bool requireFilesystem();                      // Sendet 503, solange das SPIFFS nicht bereit ist
+void handleHealth();                           // Zustand der Teilsysteme und Startzeiten (JSON)
+void handleBootStatus();                       // Statusseite, solange index.html nicht ausgeliefert werden kann
 void handleResetCalibration();                 // Setzt die Kalibrierungswerte zurück
 /* ====================================================
  * 4. Setup – Initialisierung aller Module
  * ==================================================== */
 void setup() {
-  // Serielle Kommunikation initialisieren (für Debug-Ausgaben)
+  // Serielle Kommunikation initialisieren (für Debug-Ausgaben, ohne Wartezeit)
   Serial.begin(115200);
-  delay(1000);
 
-  // ----- EEPROM initialisieren -----
+  // ----- Stufe 1: Zustand aus EEPROM, NVS und No-Init-RAM (nur Lesen, wenige ms) -----
   // EEPROM-Größe: 4 Sensoren * 4 Float-Werte = 16 Floats
   EEPROM.begin(32 * sizeof(float));
   loadCalibration();
 
-  // ----- I²C initialisieren -----
-  Wire.begin(I2C_SDA, I2C_SCL);
+  // Kumulativen Durchfluss aus dem NVS wiederherstellen
+  loadTotalizer();
 
-  // ----- ADS1115 initialisieren -----
-  Serial.println("Suche ADS1115...");
-  while (!ads.begin(0x48)) { // 0x48 ist die Standardadresse
-    Serial.println("ADS1115 nicht gefunden, versuche erneut in 1 Sekunde...");
-    delay(1000);
-  }
-  Serial.println("ADS1115 erkannt!");
-  ads.setGain(GAIN_ONE);
+  // Regeln der Ereigniserkennung aus dem NVS laden
+  loadEventRules();
 
-  // ----- SPIFFS initialisieren -----
-  if (!SPIFFS.begin(true)) {
-    Serial.println("SPIFFS Initialisierung fehlgeschlagen!");
-  }
+  // Nach einem Warmstart: Puffer, Aufnahme, Uhrzeit und V_min/V_max übernehmen
+  restoreRetainedState();
 
-  // ----- WLAN im Access Point-Modus konfigurieren -----
-  WiFi.softAPConfig(local_IP, gateway, subnet);
-  WiFi.softAP(ssid, password);
-  Serial.print("Access Point IP: ");
-  Serial.println(WiFi.softAPIP());
+  // Kennwerte: neue Sitzung, gleitende Fenster aus dem (ggf. übernommenen) 10-Minuten-Puffer
+  loadStatsWindows();
+  resetSessionStats();
+  rebuildWindowStats();
+
+  // ----- Stufe 2: WLAN im Access Point-Modus (mit Uplink zusätzlich als Station) -----
+  loadUplinkConfig();
+  startAccessPoint();
+
+  // ----- Stufe 3: Webserver-Routen definieren und Server starten -----
+  // Erste Anfrage nach dem Start erfassen (Handler vor allen Routen, beantwortet selbst nichts)
+  server.addHandler(new FirstRequestProbe());
 
-  // ----- Webserver-Routen definieren -----
   // Statische Dateien: index.html, style.css, script.js
   server.on("/", HTTP_GET, handleRoot);
   server.on("/index.html", HTTP_GET, handleRoot);
@@ -231,20 +642,53 @@ void setup() {
   server.on("/charts.html", HTTP_GET, handleChartsHtml);                    // Charts-Seite
   server.on("/api/last10min", HTTP_GET, handleLast10Min);                   // Neu: Endpunkt für Diagrammdaten der letzten 10 Minuten
   server.on("/api/loggingData", HTTP_GET, handleLoggingData);               // Neu: Endpunkt für geloggte Daten
+  server.on("/api/logdata", HTTP_GET, handleLogData);                       // Neu: Zeitfenster einer Logdatei (name, from, to, step)
   server.on("/resetCalibration", HTTP_GET, handleResetCalibration);         // Neu: Endpunkt zum Zurücksetzen der Kalibrierung
   server.on("/api/calibration", HTTP_GET, handleGetCalibration);            // Neu: Endpunkt für Kalibrierungswerte
+  server.on("/downloadzip", HTTP_GET, handleDownloadZip);                   // Neu: Alle (oder ausgewählte) Logs als ZIP
+  server.on("/api/uplink", HTTP_GET, handleGetUplink);                      // Neu: Uplink-Einstellungen und -Status
+  server.on("/api/uplink", HTTP_POST, handleSetUplink);                     // Neu: Uplink-Einstellungen setzen
+  server.on("/api/events", HTTP_GET, handleGetEvents);                      // Neu: Ereignisse seit ?since=<id>
+  server.on("/api/events/stream", HTTP_GET, handleEventStream);             // Neu: Ereignisse per Server-Sent Events
+  server.on("/api/rules", HTTP_GET, handleGetEventRules);                   // Neu: Regeln der Ereigniserkennung
+  server.on("/api/rules", HTTP_POST, handleSetEventRule);                   // Neu: eine Regel setzen
+  server.on("/api/stats", HTTP_GET, handleStats);                           // Neu: Kennwerte je Kanal (Sitzung und zwei Fenster)
+  server.on("/api/stats", HTTP_POST, handleSetStats);                       // Neu: Fensterlängen der Kennwerte setzen
+  server.on("/resetStats", HTTP_GET, handleResetStats);                     // Neu: Sitzungs-Kennwerte zurücksetzen
+  server.on("/api/health", HTTP_GET, handleHealth);                         // Neu: Zustand der Teilsysteme und Startzeiten
   server.onNotFound(handleFileRead);
 
+  // Header, die in den Handlern ausgewertet werden (WebServer speichert sonst keine)
+  static const char* headerKeys[] = {"Range", "If-Range", "Accept-Encoding", "If-None-Match", "Last-Event-ID"};
+  server.collectHeaders(headerKeys, sizeof(headerKeys) / sizeof(headerKeys[0]));
 
   server.begin();
+  subsystemResult(SUB_HTTP, true, nullptr);
+  Serial.printf("Webserver bereit nach %lu ms (Ziel %u ms)\n", (unsigned long)millis(), (unsigned)BOOT_BUDGET_MS);
+  if (millis() > BOOT_BUDGET_MS) {
+    Serial.println("Warnung: Startzeit über dem Ziel");
+  }
 
-  // ----- Durchflusssensor-Pins konfigurieren -----
+  // ----- Stufe 4: Durchflusssensoren und Alarmausgang (nur Pins, sofort bereit) -----
   pinMode(FLOW_SENSOR1_PIN, INPUT_PULLUP);
   pinMode(FLOW_SENSOR2_PIN, INPUT_PULLUP);
-
-  // ----- Interrupts binden -----
   attachInterrupt(digitalPinToInterrupt(FLOW_SENSOR1_PIN), flowSensor1ISR, FALLING);
   attachInterrupt(digitalPinToInterrupt(FLOW_SENSOR2_PIN), flowSensor2ISR, FALLING);
+  subsystemResult(SUB_FLOW, true, nullptr);
+
+  pinMode(EVENT_OUTPUT_PIN, OUTPUT);
+  digitalWrite(EVENT_OUTPUT_PIN, LOW);
+
+  // ----- Stufe 5: SPIFFS im Hintergrund einhängen (Formatieren kann Sekunden dauern) -----
+  // Auf Kern 0, damit loop() auf Kern 1 währenddessen Anfragen beantwortet
+  xTaskCreatePinnedToCore(fsTask, "fs", 4096, nullptr, 1, &fsTaskHandle, 0);
+
+  // ----- Stufe 6: ADS1115 suchen – fehlt er, versucht es loop() später erneut -----
+  Wire.begin(I2C_SDA, I2C_SCL);
+  startADC();
+
+  // Uplink-Task (wartet selbst auf das SPIFFS, weil die Outbox dort liegt)
+  startUplink();
 
   // ----- Zeitsystem initialisieren -----
   configTime(0, 0, "pool.ntp.org");
@@ -255,15 +699,21 @@ void setup() {
  * ==================================================== */
 void loop() {
   server.handleClient();
+  if (bootFirstRequestMs != 0 && bootFirstResponseMs == 0) bootFirstResponseMs = millis() | 1;   // Antwort ist raus
+  serviceSubsystems();
 
   unsigned long currentMillis = millis();
   if (currentMillis - previousMillis >= interval) {
     previousMillis = currentMillis;
+    uint32_t sampleStartUs = micros();      // Bezugspunkt für die Latenz der Ereigniserkennung
 
-    // ----- a) Drucksensoren auslesen -----
-    float pressures[4];
-    for (uint8_t i = 0; i < 4; i++) {
-      pressures[i] = readPressureSensor(i);
+    // ----- a) Drucksensoren auslesen (ohne ADS1115: NAN = kein Messwert, siehe /api/health) -----
+    bool adcReady = subsystems[SUB_ADC].state == SUB_OK && checkADC();
+    float pressures[4] = {NAN, NAN, NAN, NAN};
+    if (adcReady) {
+      for (uint8_t i = 0; i < 4; i++) {
+        pressures[i] = readPressureSensor(i);
+      }
     }
 
     // ----- b) Durchfluss auswerten -----
@@ -279,8 +729,19 @@ void loop() {
 
     flowRate1 = delta1 / 11.0;
     flowRate2 = delta2 / 11.0;
-    cumulativeFlow1 += flowRate1 / 60.0;    //  11.0 für YF-B2; 98.0 für yf-s401; 7.5 für yf-s201;
-    cumulativeFlow2 += flowRate2 / 60.0;
+    totalPulses1 += delta1;                 // exakt als Impulse, Umrechnung in Liter erst bei der Ausgabe
+    totalPulses2 += delta2;
+
+    // ----- c) Regeln prüfen (vor allen Flash- und Netzwerkzugriffen) -----
+    // Ohne ADS1115 sind die Druckkanäle NAN: Regeln darauf lösen weder aus noch werden sie aufgehoben
+    float channels[EVENT_CHANNELS] = {pressures[0], pressures[1], pressures[2], pressures[3], flowRate1, flowRate2};
+    evaluateEvents(channels, sampleStartUs);
+    pushEvents();
+
+    if (currentMillis - lastTotalizerCommit >= TOTALIZER_COMMIT_MS) {
+      lastTotalizerCommit = currentMillis;
+      commitTotalizer();
+    }
 
     // Debug-Ausgabe (optional)
     Serial.print("Puls1: ");
@@ -293,18 +754,24 @@ void loop() {
     Serial.print(flowRate2, 2);
     Serial.println(" L/min");
 
-    // --- 1) 10-Minuten-Puffer (dataBuffer) immer befüllen ---
+    // --- 1) 10-Minuten-Puffer (dataBuffer) immer befüllen (Druck ggf. NAN: Kennwerte überspringen ihn) ---
     time_t currentTime = time(nullptr);
+    for (uint8_t i = 0; i < 4; i++) {
+      latestPressures[i] = pressures[i];
+    }
+    latestSampleTime = currentTime;
     dataBuffer[bufferIndex].timestamp = currentTime;
     for (uint8_t i = 0; i < 4; i++) {
       dataBuffer[bufferIndex].pressure[i] = pressures[i];
     }
     dataBuffer[bufferIndex].flowRate1 = flowRate1;
     dataBuffer[bufferIndex].flowRate2 = flowRate2;
+    updateStats(bufferIndex);
     bufferIndex = (bufferIndex + 1) % BUFFER_SIZE;
 
     // --- 2) Wenn recording => loggingBuffer + logData() ---
-    if (recording) {
+    // Ohne Druckwerte keine Zeile: Logformat und Uplink-Pakete kennen keine fehlenden Werte
+    if (recording && adcReady) {
       // Logging-Puffer befüllen (loggingIndex hochzählen)
       loggingBuffer[loggingIndex].timestamp = currentTime;
       for (uint8_t i = 0; i < 4; i++) {
@@ -318,9 +785,25 @@ void loop() {
         loggingIndex = 0; // optionaler Ringpuffer
       }
 
-      // In die CSV-Datei schreiben
-      logData();
+      // In die CSV-Datei schreiben (erst, wenn das SPIFFS eingehängt ist)
+      if (subsystems[SUB_FS].state == SUB_OK) logData();
+    }
+
+    // Neue Ereignisse ins Protokoll schreiben (erst nach der Auswertung, damit der Flash sie nicht verzögert)
+    if (eventPersistedId != eventLastId && subsystems[SUB_FS].state == SUB_OK) {
+      persistEvents();
+    }
+
+    // --- 3) Messwert an den Uplink übergeben (nur RAM, kein Netzwerk/Flash im Messzyklus) ---
+    if (uplinkConfig.enabled && adcReady) {
+      uplinkAddSample(currentTime, pressures, flowRate1, flowRate2);
     }
+
+    // --- 4) Zustand für einen eventuellen Warmstart sichern ---
+    saveRetainedState();
+
+    // Neuer Messwert => zwischengespeicherte JSON-Antworten sind veraltet
+    sampleSeq++;
   } // Ende if (currentMillis - previousMillis >= interval)
 } // Ende loop()
 
@@ -374,50 +857,82 @@ void logData() {
     return;
   }
 
-  // Laufzeit in Sekunden seit startRecordingMillis
-  unsigned long sekunden = (millis() - startRecordingMillis) / 1000;
+  // Zeit nur einmal lesen: Indexeintrag und Zeile müssen dieselbe Sekunde tragen,
+  // sonst zeigt die binäre Suche auf die falsche Zeile
+  time_t now = time(nullptr);
 
-  // Zeitstempel
-  String timeStr = getTimeString(); 
-  // Drucksensoren abfragen
-  float pressures[4];
-  for (uint8_t i = 0; i < 4; i++) {
-    pressures[i] = readPressureSensor(i);
+  // Byte-Offset der neuen Zeile; alle LOG_INDEX_EVERY Zeilen kommt ein Eintrag in den Zeitindex
+  uint32_t rowOffset = file.size();
+  if (logRowCount % LOG_INDEX_EVERY == 0) {
+    File indexFile = SPIFFS.open(indexFileName(logFileName), FILE_APPEND);
+    if (indexFile) {
+      LogIndexEntry entry = {(uint32_t)now, rowOffset};
+      indexFile.write((const uint8_t*)&entry, sizeof(entry));
+      indexFile.close();
+    }
   }
+  logRowCount++;
 
-  // Zeile aufbauen – mit Semikolons
-  // Zeit;laufzeit;dr1;dr2;dr3;dr4;flow1;flow2;cumFlow1;cumFlow2
-  String line;
-  line += timeStr + ";";              // z. B. "2023-09-19 15:02:12;"
-  line += String(sekunden) + ";";     // "12;" (Beispiel: 12 s Laufzeit)
-
-  // Drucksensoren in bar => Komma
+  // Zeile im gemeinsamen Logformat (LogFormat.h) aufbauen, z. B.
+  // "2023-09-19 15:02:12;12;1,234;...;0,00\n"
+  LogRow row;
+  row.timestamp = now;
+  row.runtime = (millis() - startRecordingMillis) / 1000;  // Laufzeit in Sekunden
   for (uint8_t i = 0; i < 4; i++) {
-    line += toGermanFloatString(pressures[i], 3) + ";";
+    row.pressure[i] = latestPressures[i];  // Druckwerte des aktuellen Messzyklus (keine zusätzliche ADC-Wandlung)
   }
-  // Flowraten => Komma
-  line += toGermanFloatString(flowRate1, 2) + ";";
-  line += toGermanFloatString(flowRate2, 2) + ";";
+  row.flow[0] = flowRate1;
+  row.flow[1] = flowRate2;
+  row.cumulative[0] = cumulativeLiters(totalPulses1);
+  row.cumulative[1] = cumulativeLiters(totalPulses2);
+
+  char line[LOG_ROW_MAX];
+  size_t len = formatLogRow(row, line, sizeof(line));
+  file.write((const uint8_t*)line, len);
+  file.close();
+}
 
-  // Kumulierte Flows => Komma
-  line += toGermanFloatString(cumulativeFlow1, 2) + ";";
-  line += toGermanFloatString(cumulativeFlow2, 2) + "\n";
+// Zu "/x_Rohdaten.csv" gehört der Zeitindex "/x_Rohdaten.idx"
+String indexFileName(const String& csvName) {
+  return csvName.substring(0, csvName.length() - 4) + ".idx";
+}
 
-  file.print(line);
-  file.close();
+// Binäre Suche im Zeitindex: Byte-Offset des letzten Blocks, der vor oder bei t beginnt.
+// blockOut erhält die Nummer dieses Blocks (-1 = t liegt vor dem ersten Eintrag), countOut die Anzahl der Einträge.
+uint32_t findLogOffset(const String& csvName, time_t t, long& blockOut, long& countOut) {
+  blockOut = -1;
+  countOut = 0;
+  File indexFile = SPIFFS.open(indexFileName(csvName), FILE_READ);
+  if (!indexFile) return 0;
+
+  long count = indexFile.size() / sizeof(LogIndexEntry);
+  long lo = 0, hi = count - 1, found = -1;
+  LogIndexEntry entry;
+  uint32_t offset = 0;
+  while (lo <= hi) {
+    long mid = (lo + hi) / 2;
+    indexFile.seek(mid * sizeof(LogIndexEntry));
+    if (indexFile.read((uint8_t*)&entry, sizeof(entry)) != sizeof(entry)) break;
+    if ((time_t)entry.timestamp <= t) {
+      found = mid;
+      offset = entry.offset;
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  indexFile.close();
+  blockOut = found;
+  countOut = count;
+  return offset;
 }
 
 
 
 
 String getTimeString() {
-  time_t now = time(nullptr);
-  struct tm timeinfo;
-  localtime_r(&now, &timeinfo);
-  char buf[30];
-  sprintf(buf, "%04d-%02d-%02d %02d:%02d:%02d",
-          timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
-          timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+  char buf[24];
+  formatTimestamp(time(nullptr), buf, sizeof(buf));
   return String(buf);
 }
 
@@ -425,6 +940,10 @@ String getTimeString() {
  * 8. Webserver-Handler: Ausliefern statischer Dateien und API-Endpunkte
  * ==================================================== */
 void handleRoot() {
+  if (subsystems[SUB_FS].state != SUB_OK) {
+    handleBootStatus();
+    return;
+  }
   if (SPIFFS.exists("/index.html")) {
     File file = SPIFFS.open("/index.html", FILE_READ);
     server.streamFile(file, "text/html");
@@ -435,6 +954,7 @@ void handleRoot() {
 }
 
 void handleCSS() {
+  if (!requireFilesystem()) return;
   if (SPIFFS.exists("/style.css")) {
     File file = SPIFFS.open("/style.css", FILE_READ);
     server.streamFile(file, "text/css");
@@ -445,6 +965,7 @@ void handleCSS() {
 }
 
 void handleJS() {
+  if (!requireFilesystem()) return;
   if (SPIFFS.exists("/script.js")) {
     File file = SPIFFS.open("/script.js", FILE_READ);
     server.streamFile(file, "application/javascript");
@@ -455,16 +976,20 @@ void handleJS() {
 }
 
 void handleSensorwerte() {
-  float pressures[4];
-  for (uint8_t i = 0; i < 4; i++) {
-    pressures[i] = readPressureSensor(i);
-  }
-  
+  sendCachedJson(sensorwerteCache, buildSensorwerteJson);
+}
+
+// Baut die Sensorwerte aus dem letzten Messzyklus auf (keine eigene ADC-Wandlung)
+String buildSensorwerteJson() {
+  char timeBuf[24];
+  formatTimestamp(latestSampleTime, timeBuf, sizeof(timeBuf));
+
   String json = "{";
-  json += "\"time\":\"" + getTimeString() + "\",";
+  json += "\"time\":\"" + String(timeBuf) + "\",";
+  json += "\"seq\":" + String(sampleSeq) + ",";
   json += "\"pressure\":[";
   for (uint8_t i = 0; i < 4; i++) {
-    json += String(pressures[i], 3);
+    json += isnan(latestPressures[i]) ? String("null") : String(latestPressures[i], 3);
     if (i < 3) json += ",";
   }
   json += "],";
@@ -472,12 +997,68 @@ void handleSensorwerte() {
   json += String(flowRate1, 2) + "," + String(flowRate2, 2);
   json += "],";
   json += "\"cumulativeFlow\":[";
-  json += String(cumulativeFlow1, 2) + "," + String(cumulativeFlow2, 2);
+  json += String(cumulativeLiters(totalPulses1), 2) + "," + String(cumulativeLiters(totalPulses2), 2);
   json += "],";
-  json += "\"recording\":" + String(recording ? "true" : "false");
+  json += "\"recording\":" + String(recording ? "true" : "false") + ",";
+  json += "\"eventId\":" + String(eventLastId) + ",";   // ändert sich => /api/events?since=... abfragen
+  json += "\"alarms\":" + String(eventActiveMask) + ",";
+  json += "\"adc\":" + String(subsystems[SUB_ADC].state == SUB_OK ? "true" : "false");   // false => Druckwerte fehlen
   json += "}";
-  
-  server.send(200, "application/json", json);
+  return json;
+}
+
+// Setzt ETag und Cache-Control. Kennt der Client den Stand schon, geht 304 ohne Body raus.
+bool answerNotModified() {
+  String etag = "\"" + String(sampleSeq) + "." + String(stateVersion) + "\"";
+  server.sendHeader("ETag", etag);
+  server.sendHeader("Cache-Control", "no-cache");
+  if (server.header("If-None-Match") == etag) {
+    server.send(304, "application/json", "");
+    return true;
+  }
+  return false;
+}
+
+// Liefert eine gecachte JSON-Antwort (nur für kleine Bodies). Der Body wird nur neu aufgebaut,
+// wenn seit dem letzten Aufbau ein neuer Messzyklus (oder eine Zustandsänderung) stattgefunden hat.
+void sendCachedJson(ResponseCache& cache, String (*build)()) {
+  if (answerNotModified()) return;
+  if (!cache.body || cache.seq != sampleSeq || cache.version != stateVersion) {
+    // Alten Body wirklich freigeben, bevor der neue entsteht ("" behält die Kapazität)
+    delete cache.body;
+    cache.body = nullptr;
+    cache.body = new String(build());
+    cache.seq = sampleSeq;
+    cache.version = stateVersion;
+  }
+  server.send(200, "application/json", *cache.body);
+}
+
+void sendChunkIfFull(String& chunk) {
+  if (chunk.length() > 1024) {
+    server.sendContent(chunk);
+    chunk = "";
+  }
+}
+
+// Text als JSON-String in Anführungszeichen (", \ und Steuerzeichen maskiert)
+String jsonString(const String& text) {
+  String out = "\"";
+  for (unsigned int i = 0; i < text.length(); i++) {
+    char c = text[i];
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if ((uint8_t)c < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", (unsigned)(uint8_t)c);
+      out += buf;
+    } else {
+      out += c;
+    }
+  }
+  out += "\"";
+  return out;
 }
 
 void handleGetTime() {
@@ -498,10 +1079,12 @@ void handleSetTime() {
     
     // Festlegung der Zeitzone für Berlin inklusive Sommer-/Winterzeit:
     // CET ist UTC+1 im Winter, CEST UTC+2 im Sommer.
-    setenv("TZ", "CET-1CEST,M3.5.0/2,M10.5.0/3", 1);
+    setenv("TZ", LOG_TIMEZONE, 1);
     tzset();
     
     timeSet = true;  // Flag setzen – weitere Zeit-Updates werden ignoriert
+    saveRetainedState();
+    stateVersion++;
     server.send(200, "text/plain", "Zeit aktualisiert");
   } else {
     server.send(400, "text/plain", "Fehlender Parameter 't'");
@@ -509,17 +1092,216 @@ void handleSetTime() {
 }
 
 
+// Prüft, ob ein Dateiname auf eine Logdatei im SPIFFS zeigt (kein Zugriff auf andere Dateien).
+// Nur Aufnahmen ("*_Rohdaten.csv"), nicht das Ereignisprotokoll EVENT_FILE/EVENT_FILE_OLD.
+bool isLogFileName(const String& name) {
+  return name.startsWith("/") && name.endsWith("_Rohdaten.csv") && name.indexOf("..") < 0;
+}
+
+// Liefert den angeforderten Logdateinamen (?name=...) oder die aktuelle Logdatei
+String requestedLogFile() {
+  if (server.hasArg("name")) {
+    String name = server.arg("name");
+    if (!name.startsWith("/")) name = "/" + name;
+    return name;
+  }
+  return logFileName;
+}
+
+// Wertet einen "Range: bytes=..."-Header aus (nur ein Bereich wird unterstützt).
+// Gibt false zurück, wenn der Bereich nicht erfüllbar ist.
+bool parseRange(const String& header, size_t fileSize, size_t& start, size_t& end) {
+  if (!header.startsWith("bytes=") || header.indexOf(',') >= 0 || fileSize == 0) return false;
+  String spec = header.substring(6);
+  int dash = spec.indexOf('-');
+  if (dash < 0) return false;
+  String first = spec.substring(0, dash);
+  String last = spec.substring(dash + 1);
+  first.trim();
+  last.trim();
+  // Nur Ziffern zulassen: toInt() würde "abc" still als 0 lesen
+  for (unsigned int i = 0; i < first.length(); i++) if (!isDigit(first[i])) return false;
+  for (unsigned int i = 0; i < last.length(); i++) if (!isDigit(last[i])) return false;
+
+  if (first.length() == 0) {
+    // "bytes=-500" => die letzten 500 Bytes
+    long suffix = last.toInt();
+    if (suffix <= 0) return false;
+    start = (size_t)suffix >= fileSize ? 0 : fileSize - suffix;
+    end = fileSize - 1;
+    return true;
+  }
+
+  start = (size_t)first.toInt();
+  end = last.length() ? (size_t)last.toInt() : fileSize - 1;
+  if (end >= fileSize) end = fileSize - 1;
+  return start <= end;
+}
+
+// Sink für DeflateStream: komprimierte Blöcke direkt als HTTP-Chunk senden
+void httpChunkSink(void* ctx, const uint8_t* data, size_t len) {
+  (void)ctx;
+  server.sendContent((const char*)data, len);
+}
+
+// Starker Validator für Range-Anfragen: Name, letzte Änderung und Größe.
+// Eine unter gleichem Namen neu angelegte oder weitergeschriebene Datei bekommt einen anderen ETag.
+String logFileEtag(const String& name, File& file) {
+  char buf[40];
+  snprintf(buf, sizeof(buf), "\"%08lx-%lx-%lx\"",
+           (unsigned long)crc32Update(0, (const uint8_t*)name.c_str(), name.length()),
+           (unsigned long)file.getLastWrite(), (unsigned long)file.size());
+  return String(buf);
+}
+
+// /downloadlog[?name=/x.csv][&gzip=1]
+//   - ohne Range-Header: komplette Datei, auf Wunsch gzip-komprimiert (Content-Encoding)
+//   - mit Range-Header:  Teilbereich (206), damit abgebrochene Downloads fortgesetzt werden können.
+//     Passt If-Range nicht zum ETag (Datei geändert), kommt die ganze Datei (200).
 void handleDownloadLog() {
-  if (SPIFFS.exists(logFileName)) {
-    File file = SPIFFS.open(logFileName, FILE_READ);
+  if (!requireFilesystem()) return;
+  String name = requestedLogFile();
+  if (!isLogFileName(name) || !SPIFFS.exists(name)) {
+    server.send(404, "text/plain", "Logdatei nicht gefunden");
+    return;
+  }
+
+  File file = SPIFFS.open(name, FILE_READ);
+  size_t fileSize = file.size();
+  String downloadName = name.substring(1);
+  String etag = logFileEtag(name, file);
+  server.sendHeader("Content-Disposition", "attachment; filename=\"" + downloadName + "\"");
+
+  uint8_t buf[512];
+
+  bool rangeValid = !server.hasHeader("If-Range") || server.header("If-Range") == etag;
+  if (server.hasHeader("Range") && rangeValid) {
+    server.sendHeader("Accept-Ranges", "bytes");
+    server.sendHeader("ETag", etag);
+    size_t start, end;
+    if (!parseRange(server.header("Range"), fileSize, start, end)) {
+      server.sendHeader("Content-Range", "bytes */" + String(fileSize));
+      server.send(416, "text/plain", "Ungültiger Bereich");
+      file.close();
+      return;
+    }
+    size_t remaining = end - start + 1;
+    server.sendHeader("Content-Range", "bytes " + String(start) + "-" + String(end) + "/" + String(fileSize));
+    server.setContentLength(remaining);
+    server.send(206, "text/csv", "");
+    file.seek(start);
+    while (remaining > 0) {
+      size_t n = file.read(buf, remaining < sizeof(buf) ? remaining : sizeof(buf));
+      if (n == 0) break;
+      server.sendContent((const char*)buf, n);
+      remaining -= n;
+    }
+    file.close();
+    return;
+  }
+
+  bool gzip = server.arg("gzip") == "1" && server.header("Accept-Encoding").indexOf("gzip") >= 0;
+  if (!gzip) {
+    // Nur unkomprimiert fortsetzbar: ein Bereich bezieht sich immer auf die Bytes der CSV-Datei
+    server.sendHeader("Accept-Ranges", "bytes");
+    server.sendHeader("ETag", etag);
     server.streamFile(file, "text/csv");
     file.close();
-  } else {
-    server.send(404, "text/plain", "Logdatei nicht gefunden");
+    return;
+  }
+
+  // gzip-Export: Datei wird blockweise gelesen und komprimiert, nie komplett im RAM gehalten
+  GzipWriter* gz = new (std::nothrow) GzipWriter();
+  if (!gz) {
+    server.send(503, "text/plain", "Zu wenig Speicher für die Kompression");
+    file.close();
+    return;
+  }
+  server.sendHeader("Content-Encoding", "gzip");
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/csv", "");
+  gz->begin(httpChunkSink, nullptr, (uint32_t)time(nullptr));
+  size_t n;
+  while ((n = file.read(buf, sizeof(buf))) > 0) {
+    gz->write(buf, n);
+  }
+  gz->finish();
+  delete gz;
+  file.close();
+}
+
+// /downloadzip[?names=/a.csv,/b.csv][&store=1]
+// Packt alle Logdateien (oder die angegebenen) in ein ZIP, das während des Lesens gestreamt wird.
+void handleDownloadZip() {
+  if (!requireFilesystem()) return;
+  String names = "," + server.arg("names") + ",";
+  bool all = names == ",,";
+  bool deflate = server.arg("store") != "1";
+
+  // Ausgewählte Logdateien; liefert den Pfad mit führendem "/"
+  auto selectedLog = [&](File& entry, String& path) {
+    path = entry.name();
+    if (!path.startsWith("/")) path = "/" + path;
+    return !entry.isDirectory() && isLogFileName(path) && (all || names.indexOf("," + path + ",") >= 0);
+  };
+
+  // 1. Durchlauf: Dateien zählen, damit das Zentralverzeichnis passt (keine stillschweigend fehlenden Dateien)
+  uint16_t files = 0;
+  String path;
+  File root = SPIFFS.open("/");
+  for (File entry = root.openNextFile(); entry; entry = root.openNextFile()) {
+    if (selectedLog(entry, path)) files++;
+    entry.close();
+  }
+  root.close();
+  if (files > ZIP_MAX_FILES) {
+    server.send(413, "text/plain", "Zu viele Logdateien (" + String(files) + ", max. " + String(ZIP_MAX_FILES) +
+                                   ") – bitte mit names=... auswählen");
+    return;
+  }
+
+  ZipWriter* zip = new (std::nothrow) ZipWriter();
+  // +1: eine während des Downloads neu begonnene Aufnahme
+  if (!zip || !zip->begin(httpChunkSink, nullptr, files + 1, deflate)) {
+    delete zip;
+    server.send(503, "text/plain", "Zu wenig Speicher für die Kompression");
+    return;
+  }
+
+  String zipName = getFileTimestamp() + "_Logs.zip";
+  server.sendHeader("Content-Disposition", "attachment; filename=\"" + zipName + "\"");
+  server.sendHeader("X-Zip-Entries", String(files));
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/zip", "");
+
+  // 2. Durchlauf: Dateien packen
+  uint8_t buf[512];
+  root = SPIFFS.open("/");
+  File entry = root.openNextFile();
+  while (entry) {
+    if (selectedLog(entry, path)) {
+      if (!zip->beginEntry(path.c_str() + 1, (uint32_t)entry.getLastWrite())) {
+        Serial.println("ZIP voll: " + path + " und folgende Dateien ausgelassen (nach dem Zählen hinzugekommen)");
+        entry.close();
+        break;
+      }
+      size_t n;
+      while ((n = entry.read(buf, sizeof(buf))) > 0) {
+        zip->write(buf, n);
+      }
+      zip->endEntry();
+    }
+    entry.close();
+    entry = root.openNextFile();
   }
+  root.close();
+
+  zip->finish();
+  delete zip;
 }
 
 void handleToggleRecording() {
+  if (!recording && !requireFilesystem()) return;   // Anhalten geht immer, Starten braucht die Logdatei
   recording = !recording;
   if (recording) {
      // Setze den Logging-Puffer-Index zurück, damit alte Daten überschrieben werden.
@@ -527,30 +1309,37 @@ void handleToggleRecording() {
 
     // Laufzeit-Startzeit merken
     startRecordingMillis = millis();
+
+    // Kennwerte der Sitzung beziehen sich auf die neue Aufnahme
+    resetSessionStats();
     
     // Neuen Dateinamen anlegen, Header schreiben
     String filePrefix = getFileTimestamp();
     logFileName = "/" + filePrefix + "_Rohdaten.csv";
+    logRowCount = 0;
+    File indexFile = SPIFFS.open(indexFileName(logFileName), FILE_WRITE);  // leerer Zeitindex
+    if (indexFile) indexFile.close();
     File file = SPIFFS.open(logFileName, FILE_WRITE);
     if (file) {
-      // Angepasster Header mit Semikolon
-      //   Zeitstempel;Laufzeit (s);Druck1 (bar);Druck2 (bar);Druck3 (bar);Druck4 (bar);FlowRate1 (L/min);FlowRate2 (L/min);kUmFlow1 (L);kUmFlow2 (L)
-      String header = "Zeitstempel;Laufzeit (s);Pressure1 (bar);Pressure2 (bar);Pressure3 (bar);Pressure4 (bar);"
-                      "FlowRate1 (L/min);FlowRate2 (L/min);CumulativeFlow1 (L);CumulativeFlow2 (L)\n";
-      file.print(header);
+      // Header mit Semikolon (siehe LogFormat.h)
+      file.print(LOG_CSV_HEADER);
       file.close();
     } else {
       Serial.println("Fehler beim Erstellen der Logdatei");
     }
   }
+  saveRetainedState();
+  stateVersion++;
   server.send(200, "text/plain", recording ? "Recording gestartet" : "Recording gestoppt");
 }
 
 
 
 void handleDeleteLog() {
+  if (!requireFilesystem()) return;
   if (SPIFFS.exists(logFileName)) {
     SPIFFS.remove(logFileName);
+    SPIFFS.remove(indexFileName(logFileName));
     server.send(200, "text/plain", "Logdatei gelöscht");
   } else {
     server.send(404, "text/plain", "Logdatei nicht gefunden");
@@ -558,8 +1347,8 @@ void handleDeleteLog() {
 }
 
 void handleClearCumulativeFlow() {
-  cumulativeFlow1 = 0;
-  cumulativeFlow2 = 0;
+  clearTotalizer();
+  stateVersion++;
   server.send(200, "text/plain", "Kumulativer Durchfluss zurückgesetzt");
 }
 
@@ -598,8 +1387,9 @@ void handleUpdateCalibration() {
       pressureSensor_PSI_min[sensorIndex] = doc["psi_min"];
       pressureSensor_PSI_max[sensorIndex] = doc["psi_max"];
 
-      // Nur PSI-Werte bleiben EEPROM-persistent
+      // Nur PSI-Werte bleiben EEPROM-persistent, V_min/V_max überstehen nur einen Warmstart
       saveCalibration();
+      saveRetainedState();
 
       server.send(200, "application/json", "{\"status\":\"success\"}");
     } else {
@@ -613,6 +1403,7 @@ void handleUpdateCalibration() {
 
 // Fügt eine Seite hinzu, auf der die Kalibrierung in einem separaten Layout erfolgt.
 void handleCalibrateHtml() {
+  if (!requireFilesystem()) return;
   if (SPIFFS.exists("/calibrate.html")) {
     File file = SPIFFS.open("/calibrate.html", FILE_READ);
     server.streamFile(file, "text/html");
@@ -624,6 +1415,7 @@ void handleCalibrateHtml() {
 
 // Liefert die Seite, auf der wissenschaftliche Diagramme angezeigt werden.
 void handleChartsHtml() {
+  if (!requireFilesystem()) return;
   if (SPIFFS.exists("/charts.html")) {
     File file = SPIFFS.open("/charts.html", FILE_READ);
     server.streamFile(file, "text/html");
@@ -632,129 +1424,175 @@ void handleChartsHtml() {
     server.send(404, "text/plain", "Datei /charts.html nicht gefunden");
   }
 }
-// Diese Funktion liest die Logdatei, filtert alle Zeilen, die innerhalb der letzten 10 Minuten liegen,
-// und erstellt ein JSON-Objekt mit Arrays für Zeitstempel, Druck und Durchfluss.
-// --- Neu/Geändert: API-Endpunkt, der alle Messwerte der letzten 10 Minuten aus dem in-memory Puffer liefert ---
+// Streamt eine JSON-Zahlenreihe "[...]"; include(i) filtert die Einträge, value(i) liefert den Wert (NAN => null)
+template <typename Filter, typename Value>
+void streamSeries(String& chunk, int count, Filter include, Value value, unsigned int decimals) {
+  chunk += "[";
+  bool first = true;
+  for (int i = 0; i < count; i++) {
+    if (!include(i)) continue;
+    if (!first) chunk += ",";
+    first = false;
+    float v = value(i);
+    if (isnan(v)) chunk += "null";
+    else chunk += String(v, decimals);
+    sendChunkIfFull(chunk);
+  }
+  chunk += "]";
+}
+
+// Wie streamSeries, aber für Zeitstempel im Format "YYYY-MM-DD hh:mm:ss"
+template <typename Filter, typename Stamp>
+void streamTimestamps(String& chunk, int count, Filter include, Stamp stamp) {
+  chunk += "[";
+  bool first = true;
+  for (int i = 0; i < count; i++) {
+    if (!include(i)) continue;
+    if (!first) chunk += ",";
+    first = false;
+    char buf[24];
+    formatTimestamp(stamp(i), buf, sizeof(buf));
+    chunk += "\"";
+    chunk += buf;
+    chunk += "\"";
+    sendChunkIfFull(chunk);
+  }
+  chunk += "]";
+}
+
+// --- API-Endpunkt, der alle Messwerte der letzten 10 Minuten aus dem in-memory Puffer liefert ---
+// Wird in Stücken von ~1 KB gestreamt (eine Reihe nach der anderen) statt als ein String im Heap.
 void handleLast10Min() {
+  if (answerNotModified()) return;
+
   time_t now = time(nullptr);
   time_t tenMinutesAgo = now - 600;  // 600 Sekunden = 10 Minuten
-  
-  String timestampsArr = "";
-  String pressure1Arr = "";
-  String pressure2Arr = "";
-  String pressure3Arr = "";
-  String pressure4Arr = "";
-  String flow1Arr = "";
-  String flow2Arr = "";
-  bool firstElement = true;
-
-  // Durchlaufe den zirkulären Puffer
-  for (int i = 0; i < BUFFER_SIZE; i++) {
-    // Nur Einträge, die gesetzt wurden (timestamp != 0) und innerhalb der letzten 10 Minuten liegen, berücksichtigen
-    if (dataBuffer[i].timestamp != 0 && dataBuffer[i].timestamp >= tenMinutesAgo && dataBuffer[i].timestamp <= now) {
-      if (!firstElement) {
-        timestampsArr += ",";
-        pressure1Arr += ",";
-        pressure2Arr += ",";
-        pressure3Arr += ",";
-        pressure4Arr += ",";
-        flow1Arr += ",";
-        flow2Arr += ",";
-      } else {
-        firstElement = false;
-      }
-      char buf[30];
-      struct tm t;
-      localtime_r(&(dataBuffer[i].timestamp), &t);
-      sprintf(buf, "%04d-%02d-%02d %02d:%02d:%02d", t.tm_year+1900, t.tm_mon+1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec);
-      timestampsArr += "\"" + String(buf) + "\"";
-      pressure1Arr += String(dataBuffer[i].pressure[0], 3);
-      pressure2Arr += String(dataBuffer[i].pressure[1], 3);
-      pressure3Arr += String(dataBuffer[i].pressure[2], 3);
-      pressure4Arr += String(dataBuffer[i].pressure[3], 3);
-      flow1Arr += String(dataBuffer[i].flowRate1, 2);
-      flow2Arr += String(dataBuffer[i].flowRate2, 2);
-    }
-  }
-  
-  String json = "{";
-  json += "\"timestamps\":[" + timestampsArr + "],";
-  json += "\"pressure\":{";
-  json += "\"sensor1\":[" + pressure1Arr + "],";
-  json += "\"sensor2\":[" + pressure2Arr + "],";
-  json += "\"sensor3\":[" + pressure3Arr + "],";
-  json += "\"sensor4\":[" + pressure4Arr + "]";
-  json += "},";
-  json += "\"flow\":{";
-  json += "\"sensor1\":[" + flow1Arr + "],";
-  json += "\"sensor2\":[" + flow2Arr + "]";
-  json += "}";
-  json += "}";
-  server.send(200, "application/json", json);
+
+  // Nur Einträge, die gesetzt wurden (timestamp != 0) und innerhalb der letzten 10 Minuten liegen
+  auto valid = [&](int i) {
+    return dataBuffer[i].timestamp != 0 && dataBuffer[i].timestamp >= tenMinutesAgo && dataBuffer[i].timestamp <= now;
+  };
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  String chunk;
+  chunk.reserve(1200);
+  chunk += "{\"timestamps\":";
+  streamTimestamps(chunk, BUFFER_SIZE, valid, [](int i) { return dataBuffer[i].timestamp; });
+  chunk += ",\"pressure\":{\"sensor1\":";
+  streamSeries(chunk, BUFFER_SIZE, valid, [](int i) { return dataBuffer[i].pressure[0]; }, 3);
+  chunk += ",\"sensor2\":";
+  streamSeries(chunk, BUFFER_SIZE, valid, [](int i) { return dataBuffer[i].pressure[1]; }, 3);
+  chunk += ",\"sensor3\":";
+  streamSeries(chunk, BUFFER_SIZE, valid, [](int i) { return dataBuffer[i].pressure[2]; }, 3);
+  chunk += ",\"sensor4\":";
+  streamSeries(chunk, BUFFER_SIZE, valid, [](int i) { return dataBuffer[i].pressure[3]; }, 3);
+  chunk += "},\"flow\":{\"sensor1\":";
+  streamSeries(chunk, BUFFER_SIZE, valid, [](int i) { return dataBuffer[i].flowRate1; }, 2);
+  chunk += ",\"sensor2\":";
+  streamSeries(chunk, BUFFER_SIZE, valid, [](int i) { return dataBuffer[i].flowRate2; }, 2);
+  chunk += "}}";
+  server.sendContent(chunk);
 }
 
+// Diagrammdaten der laufenden Aufnahme, gestreamt wie /api/last10min
 void handleLoggingData() {
-  // Wir gehen davon aus, dass Einträge 0..(loggingIndex-1) gültig sind
-  // (Falls du einen fortlaufenden Ring willst, passt du es an.)
-
-  String timestampsArr;
-  String pressure1Arr, pressure2Arr, pressure3Arr, pressure4Arr;
-  String flow1Arr, flow2Arr;
-  bool firstElement = true;
-
-  for (int i = 0; i < loggingIndex; i++) {
-    if (!firstElement) {
-      timestampsArr += ",";
-      pressure1Arr  += ",";
-      pressure2Arr  += ",";
-      pressure3Arr  += ",";
-      pressure4Arr  += ",";
-      flow1Arr      += ",";
-      flow2Arr      += ",";
-    } else {
-      firstElement = false;
-    }
+  if (answerNotModified()) return;
 
-    // Zeitstempel
-    time_t t = loggingBuffer[i].timestamp;
-    struct tm tmStruct;
-    localtime_r(&t, &tmStruct);
-    char buf[30];
-    sprintf(buf, "%04d-%02d-%02d %02d:%02d:%02d",
-            tmStruct.tm_year+1900, tmStruct.tm_mon+1, tmStruct.tm_mday,
-            tmStruct.tm_hour, tmStruct.tm_min, tmStruct.tm_sec);
-    timestampsArr += "\"" + String(buf) + "\"";
-
-    // Druck
-    pressure1Arr += String(loggingBuffer[i].pressure[0], 3);
-    pressure2Arr += String(loggingBuffer[i].pressure[1], 3);
-    pressure3Arr += String(loggingBuffer[i].pressure[2], 3);
-    pressure4Arr += String(loggingBuffer[i].pressure[3], 3);
+  // Wir gehen davon aus, dass Einträge 0..(loggingIndex-1) gültig sind
+  auto valid = [](int i) { return loggingBuffer[i].timestamp != 0; };   // 0 = beim Warmstart verworfen
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  String chunk;
+  chunk.reserve(1200);
+  chunk += "{\"timestamps\":";
+  streamTimestamps(chunk, loggingIndex, valid, [](int i) { return loggingBuffer[i].timestamp; });
+  chunk += ",\"pressure\":{\"sensor1\":";
+  streamSeries(chunk, loggingIndex, valid, [](int i) { return loggingBuffer[i].pressure[0]; }, 3);
+  chunk += ",\"sensor2\":";
+  streamSeries(chunk, loggingIndex, valid, [](int i) { return loggingBuffer[i].pressure[1]; }, 3);
+  chunk += ",\"sensor3\":";
+  streamSeries(chunk, loggingIndex, valid, [](int i) { return loggingBuffer[i].pressure[2]; }, 3);
+  chunk += ",\"sensor4\":";
+  streamSeries(chunk, loggingIndex, valid, [](int i) { return loggingBuffer[i].pressure[3]; }, 3);
+  chunk += "},\"flow\":{\"sensor1\":";
+  streamSeries(chunk, loggingIndex, valid, [](int i) { return loggingBuffer[i].flow1; }, 2);
+  chunk += ",\"sensor2\":";
+  streamSeries(chunk, loggingIndex, valid, [](int i) { return loggingBuffer[i].flow2; }, 2);
+  chunk += "}}";
+  server.sendContent(chunk);
+}
 
-    // Flow
-    flow1Arr += String(loggingBuffer[i].flow1, 2);
-    flow2Arr += String(loggingBuffer[i].flow2, 2);
+// /api/logdata?name=/x.csv[&from=<unix>][&to=<unix>][&step=n | &max=n]
+// Springt über den Zeitindex an den Anfang des Zeitfensters und streamt nur dessen Zeilen
+// (zeilenweise: [Zeit, Druck1..4, Flow1..2]). step/max dünnen die Zeilen gleichmäßig aus.
+void handleLogData() {
+  if (!requireFilesystem()) return;
+  String name = requestedLogFile();
+  if (!isLogFileName(name) || !SPIFFS.exists(name)) {
+    server.send(404, "text/plain", "Logdatei nicht gefunden");
+    return;
   }
 
-  // JSON
-  String json = "{";
-  json += "\"timestamps\":[" + timestampsArr + "],";
-  json += "\"pressure\":{";
-  json += "\"sensor1\":[" + pressure1Arr + "],";
-  json += "\"sensor2\":[" + pressure2Arr + "],";
-  json += "\"sensor3\":[" + pressure3Arr + "],";
-  json += "\"sensor4\":[" + pressure4Arr + "]";
-  json += "},";
-  json += "\"flow\":{";
-  json += "\"sensor1\":[" + flow1Arr + "],";
-  json += "\"sensor2\":[" + flow2Arr + "]";
-  json += "}";
-  json += "}";
+  time_t from = server.hasArg("from") ? (time_t)server.arg("from").toInt() : 0;
+  time_t to = server.hasArg("to") ? (time_t)server.arg("to").toInt() : (time_t)0x7FFFFFFF;
+  long block, blocks;
+  uint32_t offset = findLogOffset(name, from, block, blocks);
+
+  long step = server.hasArg("step") ? server.arg("step").toInt() : 1;
+  if (server.hasArg("max") && blocks > 0) {
+    // Zeilenzahl im Fenster über den Index abschätzen
+    long dummy, lastBlock;
+    findLogOffset(name, to, lastBlock, dummy);
+    long rows = (lastBlock - (block < 0 ? 0 : block) + 1) * LOG_INDEX_EVERY;
+    long maxRows = server.arg("max").toInt();
+    if (maxRows > 0) step = (rows + maxRows - 1) / maxRows;
+  }
+  if (step < 1) step = 1;
+
+  File file = SPIFFS.open(name, FILE_READ);
+  file.seek(offset);
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  server.sendContent("{\"columns\":[\"time\",\"pressure1\",\"pressure2\",\"pressure3\",\"pressure4\",\"flow1\",\"flow2\"],"
+                     "\"step\":" + String(step) + ",\"rows\":[");
+
+  char line[160];
+  String chunk;
+  long matched = 0;
+  long sent = 0;
+  while (file.available()) {
+    size_t len = file.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[len] = '\0';
+
+    LogRow row;
+    if (!parseLogRow(line, len, row)) continue;   // Kopfzeile oder beschädigte Zeile
+    if (row.timestamp < from) continue;
+    if (row.timestamp > to) break;
+    if (matched++ % step != 0) continue;
+
+    if (sent++ > 0) chunk += ",";
+    chunk += "[\"";
+    chunk.concat(line, 19);
+    chunk += "\"";
+    for (uint8_t i = 0; i < 4; i++) chunk += "," + String(row.pressure[i], 3);
+    chunk += "," + String(row.flow[0], 2) + "," + String(row.flow[1], 2) + "]";
+
+    if (chunk.length() > 1024) {
+      server.sendContent(chunk);
+      chunk = "";
+    }
+  }
+  file.close();
 
-  server.send(200, "application/json", json);
+  chunk += "],\"count\":" + String(sent) + "}";
+  server.sendContent(chunk);
 }
 
 void handleFileRead() {
+  if (!requireFilesystem()) return;
   String path = server.uri(); // z.B. "/chart.umd.min.js"
   if (SPIFFS.exists(path)) {
     File file = SPIFFS.open(path, FILE_READ);
@@ -844,6 +1682,7 @@ float calibrateSensorVmin(uint8_t sensorIndex) {
   // 4) Setze den neuen v_min und verschiebe v_max um denselben Betrag
   pressureSensor_V_min[sensorIndex] = median;
   pressureSensor_V_max[sensorIndex] = oldVmax + shift;
+  saveRetainedState();
 
   // Debug-Ausgabe
   Serial.printf(
@@ -858,6 +1697,10 @@ float calibrateSensorVmin(uint8_t sensorIndex) {
 
 // Neuer Handler für den GET-Endpoint /calibrateVmin?sensor=X
 void handleCalibrateVmin() {
+  if (subsystems[SUB_ADC].state != SUB_OK) {
+    server.send(503, "application/json", "{\"status\":\"no_adc\"}");
+    return;
+  }
   if (server.hasArg("sensor")) {
       int sensorIndex = server.arg("sensor").toInt();
       if (sensorIndex >= 0 && sensorIndex < 4) {
@@ -904,3 +1747,1329 @@ void loadCalibration() {
     if (isnan(pressureSensor_PSI_max[i])) pressureSensor_PSI_max[i] = 10.0;
   }
 }
+
+/* ====================================================
+ * 10. Totalisator: Impulssummen im NVS (Journal mit rotierenden Slots)
+ * ==================================================== */
+// Liefert den NVS-Schlüssel eines Journal-Slots ("j1".."j7")
+void totalizerSlotKey(uint32_t seq, char* key) {
+  sprintf(key, "j%u", (unsigned)(seq % TOTALIZER_SLOTS));
+}
+
+void loadTotalizer() {
+  totalizerPrefs.begin("totalizer", false);
+
+  TotalizerBase base = {{0, 0}, 0};
+  if (totalizerPrefs.getBytes("base", &base, sizeof(base)) != sizeof(base)) {
+    base = {{0, 0}, 0};
+  }
+
+  // Journal lückenlos ab base.seq + 1 anwenden; ältere oder fehlende Slots beenden die Kette
+  uint64_t pulses[2] = {base.pulses[0], base.pulses[1]};
+  uint32_t seq = base.seq;
+  while (true) {
+    char key[8];
+    totalizerSlotKey(seq + 1, key);
+    TotalizerDelta entry;
+    if (totalizerPrefs.getBytes(key, &entry, sizeof(entry)) != sizeof(entry)) break;
+    if (entry.seq != seq + 1) break;
+    pulses[0] += entry.delta[0];
+    pulses[1] += entry.delta[1];
+    seq++;
+  }
+
+  totalPulses1 = pulses[0];
+  totalPulses2 = pulses[1];
+  committedPulses[0] = pulses[0];
+  committedPulses[1] = pulses[1];
+  totalizerSeq = seq;
+
+  Serial.printf("Totalisator geladen: %.2f L / %.2f L (Seq %u)\n",
+                cumulativeLiters(totalPulses1), cumulativeLiters(totalPulses2), (unsigned)seq);
+}
+
+// Wird aus dem Messzyklus aufgerufen: schreibt nur 12 Byte (oder nach einem Umlauf den Basisstand)
+void commitTotalizer() {
+  uint64_t pulses[2] = {totalPulses1, totalPulses2};
+  uint32_t delta[2] = {(uint32_t)(pulses[0] - committedPulses[0]), (uint32_t)(pulses[1] - committedPulses[1])};
+  if (delta[0] == 0 && delta[1] == 0) return;   // kein Durchfluss => kein Flash-Schreibzugriff
+
+  totalizerSeq++;
+  if (totalizerSeq % TOTALIZER_SLOTS == 0) {
+    // Umlauf beendet: Basisstand neu schreiben, die alten Journal-Einträge sind damit überholt
+    TotalizerBase base = {{pulses[0], pulses[1]}, totalizerSeq};
+    totalizerPrefs.putBytes("base", &base, sizeof(base));
+  } else {
+    char key[8];
+    totalizerSlotKey(totalizerSeq, key);
+    TotalizerDelta entry = {totalizerSeq, {delta[0], delta[1]}};
+    totalizerPrefs.putBytes(key, &entry, sizeof(entry));
+  }
+  committedPulses[0] = pulses[0];
+  committedPulses[1] = pulses[1];
+}
+
+void clearTotalizer() {
+  totalPulses1 = 0;
+  totalPulses2 = 0;
+  committedPulses[0] = 0;
+  committedPulses[1] = 0;
+
+  // Neuer Basisstand mit höherer Sequenznummer macht alle Journal-Einträge ungültig
+  totalizerSeq++;
+  TotalizerBase base = {{0, 0}, totalizerSeq};
+  totalizerPrefs.putBytes("base", &base, sizeof(base));
+}
+
+/* ====================================================
+ * 11. Warmstart: Zustand im No-Init-RAM
+ * ==================================================== */
+uint32_t retainedCrc() {
+  return crc32Update(0, (const uint8_t*)&retained, offsetof(RetainedState, crc));
+}
+
+// CRC-32 eines Blocks (RETAINED_BLOCK Einträge, der letzte ggf. kürzer)
+template <typename T>
+uint32_t retainedBlockCrc(const T* buffer, int size, int block) {
+  int first = block * RETAINED_BLOCK;
+  int count = size - first < RETAINED_BLOCK ? size - first : RETAINED_BLOCK;
+  return crc32Update(0, (const uint8_t*)(buffer + first), count * sizeof(T));
+}
+
+// Leert Blöcke, deren CRC nicht stimmt (timestamp 0 = leerer Eintrag). Gibt die Anzahl zurück.
+template <typename T>
+int dropDamagedBlocks(T* buffer, int size, const uint32_t* crcs, int blocks) {
+  int dropped = 0;
+  for (int b = 0; b < blocks; b++) {
+    if (crcs[b] == retainedBlockCrc(buffer, size, b)) continue;
+    int first = b * RETAINED_BLOCK;
+    int count = size - first < RETAINED_BLOCK ? size - first : RETAINED_BLOCK;
+    memset(buffer + first, 0, count * sizeof(T));
+    dropped++;
+  }
+  return dropped;
+}
+
+void restoreRetainedState() {
+  esp_reset_reason_t reason = esp_reset_reason();
+  bool ramKept = reason == ESP_RST_SW || reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT ||
+                 reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT || reason == ESP_RST_EXT;
+
+  bool valid = ramKept &&
+               retained.magic == RETAINED_MAGIC &&
+               retained.layout == RETAINED_LAYOUT &&
+               retained.crc == retainedCrc() &&
+               retained.bufferIndex >= 0 && retained.bufferIndex < BUFFER_SIZE &&
+               retained.loggingIndex >= 0 && retained.loggingIndex < LOGGING_BUFFER_SIZE;
+
+  if (!valid) {
+    // Kaltstart: Puffer enthalten zufällige Daten und werden geleert
+    memset(dataBuffer, 0, sizeof(dataBuffer));
+    memset(loggingBuffer, 0, sizeof(loggingBuffer));
+    bufferIndex = 0;
+    loggingIndex = 0;
+    warmRestart = false;
+    for (int b = 0; b < DATA_BLOCKS; b++) retained.dataCrc[b] = retainedBlockCrc(dataBuffer, BUFFER_SIZE, b);
+    for (int b = 0; b < LOGGING_BLOCKS; b++) retained.loggingCrc[b] = retainedBlockCrc(loggingBuffer, LOGGING_BUFFER_SIZE, b);
+    saveRetainedState();
+    return;
+  }
+
+  // Ringpuffer weiterführen; Blöcke, die mitten im Schreiben oder durch den Absturz beschädigt wurden, fallen weg
+  bufferIndex = retained.bufferIndex;
+  loggingIndex = retained.loggingIndex;
+  int dropped = dropDamagedBlocks(dataBuffer, BUFFER_SIZE, retained.dataCrc, DATA_BLOCKS) +
+                dropDamagedBlocks(loggingBuffer, LOGGING_BUFFER_SIZE, retained.loggingCrc, LOGGING_BLOCKS);
+
+  // Uhrzeit: nur zurückstellen, wenn die Systemzeit den Neustart nicht überlebt hat
+  if (retained.timeSet) {
+    if (time(nullptr) < retained.wallClock) {
+      struct timeval tv;
+      tv.tv_sec = retained.wallClock + 1;      // Neustart dauert etwa eine Sekunde
+      tv.tv_usec = 0;
+      settimeofday(&tv, NULL);
+    }
+    setenv("TZ", LOG_TIMEZONE, 1);
+    tzset();
+    timeSet = true;
+  }
+
+  // Laufzeit-Kalibrierung (wird sonst von loadCalibration() auf 0.5/4.5 V gesetzt)
+  for (uint8_t i = 0; i < 4; i++) {
+    pressureSensor_V_min[i] = retained.vMin[i];
+    pressureSensor_V_max[i] = retained.vMax[i];
+  }
+
+  // Totalisator: der RAM-Stand ist genauer als der letzte Commit, wenn er zur selben NVS-Sequenz gehört
+  if (retained.totalizerSeq == totalizerSeq) {
+    totalPulses1 = retained.totalPulses[0];
+    totalPulses2 = retained.totalPulses[1];
+  }
+
+  // Aufnahme fortsetzen
+  recording = retained.recording;
+  if (recording) {
+    logFileName = retained.logFileName;
+    logRowCount = retained.logRowCount;
+    startRecordingMillis = millis() - retained.recordingMillis;
+  }
+
+  warmRestart = true;
+  Serial.printf("Warmstart: Zustand übernommen (Aufnahme %s, Puffer %d/%d, %d Blöcke verworfen)\n",
+                recording ? logFileName.c_str() : "aus", bufferIndex, loggingIndex, dropped);
+}
+
+void saveRetainedState() {
+  retained.magic = RETAINED_MAGIC;
+  retained.layout = RETAINED_LAYOUT;
+  retained.bufferIndex = bufferIndex;
+  retained.loggingIndex = loggingIndex;
+  retained.recording = recording;
+  strncpy(retained.logFileName, logFileName.c_str(), sizeof(retained.logFileName) - 1);
+  retained.logFileName[sizeof(retained.logFileName) - 1] = '\0';
+  retained.logRowCount = logRowCount;
+  retained.recordingMillis = recording ? millis() - startRecordingMillis : 0;
+  retained.timeSet = timeSet;
+  retained.wallClock = time(nullptr);
+  for (uint8_t i = 0; i < 4; i++) {
+    retained.vMin[i] = pressureSensor_V_min[i];
+    retained.vMax[i] = pressureSensor_V_max[i];
+  }
+  retained.totalPulses[0] = totalPulses1;
+  retained.totalPulses[1] = totalPulses2;
+  retained.totalizerSeq = totalizerSeq;
+
+  // Nur die Blöcke mit dem zuletzt geschriebenen Eintrag haben sich geändert
+  int dataBlock = (bufferIndex + BUFFER_SIZE - 1) % BUFFER_SIZE / RETAINED_BLOCK;
+  int loggingBlock = (loggingIndex + LOGGING_BUFFER_SIZE - 1) % LOGGING_BUFFER_SIZE / RETAINED_BLOCK;
+  retained.dataCrc[dataBlock] = retainedBlockCrc(dataBuffer, BUFFER_SIZE, dataBlock);
+  retained.loggingCrc[loggingBlock] = retainedBlockCrc(loggingBuffer, LOGGING_BUFFER_SIZE, loggingBlock);
+  retained.crc = retainedCrc();
+}
+
+/* ====================================================
+ * 12. Telemetrie-Uplink: Pakete sammeln, in der Outbox puffern, senden
+ * ==================================================== */
+void loadUplinkConfig() {
+  uplinkConfigMutex = xSemaphoreCreateMutex();
+  uplinkPrefs.begin("uplink", false);
+  uplinkConfig.enabled = uplinkPrefs.getBool("enabled", false);
+  uplinkConfig.staSsid = uplinkPrefs.getString("ssid", "");
+  uplinkConfig.staPassword = uplinkPrefs.getString("pass", "");
+  uplinkConfig.collectorUrl = uplinkPrefs.getString("url", "");
+  uplinkConfig.stationId = uplinkPrefs.getString("station", WiFi.macAddress());
+  uplinkConfig.batchSeconds = uplinkPrefs.getUInt("batch", 60);
+  uplinkConfig.gzip = uplinkPrefs.getBool("gzip", true);
+  if (uplinkConfig.batchSeconds < 1 || uplinkConfig.batchSeconds > UPLINK_MAX_SAMPLES) {
+    uplinkConfig.batchSeconds = 60;
+  }
+  uplinkNextSeq = uplinkPrefs.getUInt("seq", 0);
+}
+
+// Dateiname eines Pakets im Outbox-Ordner (.gz = komprimiert, .bin = roh)
+String uplinkFileName(uint32_t seq, bool gzip) {
+  char buf[24];
+  sprintf(buf, "/outbox/%08lx", (unsigned long)seq);
+  return String(buf) + (gzip ? ".gz" : ".bin");
+}
+
+// Vorhandene Datei eines Pakets – die Einstellung gzip kann sich seit dem Schreiben geändert haben
+String uplinkExistingFile(uint32_t seq) {
+  String name = uplinkFileName(seq, true);
+  return SPIFFS.exists(name) ? name : uplinkFileName(seq, false);
+}
+
+void startUplink() {
+  if (!uplinkConfig.enabled) return;
+
+  if (uplinkConfig.staSsid.length() > 0) {
+    WiFi.setAutoReconnect(true);
+    WiFi.begin(uplinkConfig.staSsid.c_str(), uplinkConfig.staPassword.c_str());
+  }
+
+  // Läuft der Task noch, sieht er enabled beim nächsten Durchlauf wieder und macht weiter.
+  // Der Mutex hält ihn davon ab, sich zwischen Prüfung und Neustart zu beenden.
+  xSemaphoreTake(uplinkConfigMutex, portMAX_DELAY);
+  if (!uplinkTaskHandle) {
+    uplinkBatch.header.count = 0;
+    if (!uplinkQueue) uplinkQueue = xQueueCreate(2, sizeof(UplinkBatch));
+    // Auf Kern 0 (WLAN), damit loop() auf Kern 1 nie auf das Netzwerk wartet
+    xTaskCreatePinnedToCore(uplinkTask, "uplink", 8192, nullptr, 1, &uplinkTaskHandle, 0);
+  }
+  xSemaphoreGive(uplinkConfigMutex);
+}
+
+void stopUplink() {
+  WiFi.setAutoReconnect(false);
+  WiFi.disconnect();
+  WiFi.mode(WIFI_AP);
+  uplinkBatch.header.count = 0;                // angefangenes Paket verwerfen
+}
+
+// Übergibt das gefüllte Paket an den Uplink-Task
+void uplinkFlushBatch() {
+  // Nicht blockieren: ist die Queue voll, geht dieses Paket verloren
+  if (xQueueSend(uplinkQueue, &uplinkBatch, 0) != pdTRUE) uplinkDropped++;
+  uplinkBatch.header.count = 0;
+}
+
+void uplinkAddSample(time_t t, const float* pressures, float flow1, float flow2) {
+  UplinkBatchHeader& h = uplinkBatch.header;
+  // Uhr zurückgestellt oder Lücke > 18 h (z.B. /setTime): dt passt nicht mehr in 16 Bit, neues Paket beginnen
+  if (h.count > 0 && (t < (time_t)h.firstTime || t - (time_t)h.firstTime > 65535)) {
+    uplinkFlushBatch();
+  }
+  if (h.count == 0) {
+    memcpy(h.magic, "FLB1", 4);
+    h.firstTime = (uint32_t)t;
+    h.flags = 0;
+  }
+
+  UplinkSample& sample = uplinkBatch.samples[h.count];
+  sample.dt = (uint16_t)(t - h.firstTime);
+  for (uint8_t i = 0; i < 4; i++) {
+    float mbar = pressures[i] * 1000.0f;
+    sample.pressure[i] = (int16_t)constrain(mbar, -32768.0f, 32767.0f);
+  }
+  sample.flow[0] = (uint16_t)constrain(flow1 * 100.0f, 0.0f, 65535.0f);
+  sample.flow[1] = (uint16_t)constrain(flow2 * 100.0f, 0.0f, 65535.0f);
+  h.count++;
+
+  if (h.count >= uplinkConfig.batchSeconds) uplinkFlushBatch();
+}
+
+// Ältestes Paket aus der Outbox entfernen
+void uplinkDropHead() {
+  xSemaphoreTake(uplinkConfigMutex, portMAX_DELAY);
+  uint32_t seq = uplinkHeadSeq++;
+  xSemaphoreGive(uplinkConfigMutex);
+  SPIFFS.remove(uplinkExistingFile(seq));
+}
+
+// Wartezeit nach failures Fehlschlägen in Folge: 1, 2, 4, ... s, höchstens UPLINK_BACKOFF_MAX_S,
+// mit bis zu 25 % Zufallsanteil, damit mehrere Stationen nicht im Gleichtakt wiederholen
+uint32_t uplinkBackoff(uint8_t failures) {
+  uint32_t ms = failures >= 9 ? UPLINK_BACKOFF_MAX_S * 1000UL : (1000UL << (failures - 1));
+  if (ms > UPLINK_BACKOFF_MAX_S * 1000UL) ms = UPLINK_BACKOFF_MAX_S * 1000UL;
+  return ms - random(ms / 4 + 1);
+}
+
+// Sink für den GzipWriter: hängt an einen String an (Pakete sind nur wenige KB groß)
+void stringSink(void* ctx, const uint8_t* data, size_t len) {
+  static_cast<String*>(ctx)->concat((const char*)data, len);
+}
+
+// Schreibt ein fertiges Paket in den Outbox-Ordner (optional gzip-komprimiert)
+void uplinkPersist(UplinkBatch& batch, bool gzip) {
+  // Outbox voll: ältestes Paket verwerfen, damit aktuelle Daten Vorrang haben
+  if (uplinkNextSeq - uplinkHeadSeq >= UPLINK_OUTBOX_MAX) {
+    uplinkDropHead();
+    uplinkDropped++;
+  }
+
+  batch.header.seq = uplinkNextSeq;
+  size_t len = sizeof(UplinkBatchHeader) + batch.header.count * sizeof(UplinkSample);
+
+  File file = SPIFFS.open(uplinkFileName(uplinkNextSeq, gzip), FILE_WRITE);
+  if (!file) {
+    uplinkDropped++;
+    return;
+  }
+  GzipWriter* gz = gzip ? new (std::nothrow) GzipWriter() : nullptr;
+  if (gz) {
+    String packed;
+    gz->begin(stringSink, &packed, batch.header.firstTime);
+    gz->write((const uint8_t*)&batch, len);
+    gz->finish();
+    delete gz;
+    file.write((const uint8_t*)packed.c_str(), packed.length());
+  } else {
+    file.write((const uint8_t*)&batch, len);
+  }
+  file.close();
+
+  xSemaphoreTake(uplinkConfigMutex, portMAX_DELAY);
+  uplinkNextSeq++;
+  xSemaphoreGive(uplinkConfigMutex);
+  uplinkPrefs.putUInt("seq", uplinkNextSeq);
+}
+
+// Sendet das älteste Paket. Rückgabe: HTTP-Status oder negativer Fehlercode
+int uplinkSendHead(const UplinkConfig& config) {
+  String name = uplinkExistingFile(uplinkHeadSeq);
+  if (!SPIFFS.exists(name)) return 0;
+  File file = SPIFFS.open(name, FILE_READ);
+  if (!file) return 0;
+  size_t size = file.size();
+  uint8_t* payload = (uint8_t*)malloc(size);
+  if (!payload) {
+    file.close();
+    return -100;
+  }
+  file.read(payload, size);
+  file.close();
+
+  HTTPClient http;
+  http.setTimeout(5000);
+  http.begin(config.collectorUrl);
+  http.addHeader("Content-Type", "application/octet-stream");
+  http.addHeader("X-Station", config.stationId);
+  http.addHeader("X-Batch-Seq", String(uplinkHeadSeq));
+  if (name.endsWith(".gz")) http.addHeader("Content-Encoding", "gzip");
+  int status = http.POST(payload, size);
+  http.end();
+  free(payload);
+  return status;
+}
+
+void uplinkTask(void* param) {
+  (void)param;
+
+  // Die Outbox liegt im SPIFFS: warten, bis fsTask es eingehängt hat
+  while (subsystems[SUB_FS].state != SUB_OK) {
+    vTaskDelay(pdMS_TO_TICKS(100));
+  }
+
+  // Vorhandene Pakete (z.B. vor einem Neustart nicht gesendete) einsammeln
+  uint32_t head = uplinkNextSeq;
+  File dir = SPIFFS.open("/outbox");
+  File entry = dir.openNextFile();
+  while (entry) {
+    String path = entry.name();
+    uint32_t seq = strtoul(path.substring(path.lastIndexOf('/') + 1).c_str(), nullptr, 16);
+    if (uplinkNextSeq - seq <= UPLINK_OUTBOX_MAX && seq < head) head = seq;
+    entry.close();
+    entry = dir.openNextFile();
+  }
+  dir.close();
+  xSemaphoreTake(uplinkConfigMutex, portMAX_DELAY);
+  uplinkHeadSeq = head;
+  xSemaphoreGive(uplinkConfigMutex);
+
+  UplinkBatch* batch = new UplinkBatch();     // Empfangspuffer (einmalig, nicht auf dem Task-Stack)
+  UplinkConfig config;                        // eigene Kopie, damit loop() uplinkConfig jederzeit ändern darf
+  uint8_t failures = 0;                       // Fehlschläge in Folge (Netzwerk, 5xx, 4xx)
+  uint8_t rejected = 0;
+  unsigned long lastFailure = 0;
+
+  while (true) {
+    // 1) Neue Pakete aus dem Messzyklus in die Outbox schreiben (wartet max. 1 s)
+    bool received = xQueueReceive(uplinkQueue, batch, pdMS_TO_TICKS(1000)) == pdTRUE;
+
+    xSemaphoreTake(uplinkConfigMutex, portMAX_DELAY);
+    config = uplinkConfig;
+    if (!config.enabled && !received) {
+      // Abgeschaltet und nichts mehr zu schreiben: beenden (startUplink() legt bei Bedarf einen neuen Task an)
+      uplinkTaskHandle = nullptr;
+      xSemaphoreGive(uplinkConfigMutex);
+      break;
+    }
+    xSemaphoreGive(uplinkConfigMutex);
+
+    if (received) uplinkPersist(*batch, config.gzip);
+
+    // 2) Outbox in Reihenfolge abarbeiten, solange eine Verbindung besteht
+    if (!config.enabled || uplinkHeadSeq == uplinkNextSeq || WiFi.status() != WL_CONNECTED) continue;
+    if (config.collectorUrl.length() == 0) continue;
+    if (uplinkBackoffMs > 0 && millis() - lastFailure < uplinkBackoffMs) continue;
+
+    int status = uplinkSendHead(config);
+    uplinkLastStatus = status;
+    if (status == 0 || (status >= 200 && status < 300)) {
+      // Erfolgreich (oder Datei fehlt): nächstes Paket
+      uplinkDropHead();
+      if (status != 0) uplinkSent++;
+      failures = 0;
+      uplinkBackoffMs = 0;
+      rejected = 0;
+      continue;
+    }
+
+    if (status >= 400 && status < 500 && ++rejected >= UPLINK_MAX_RETRIES) {
+      // Dauerhaft abgelehnt: verwerfen, damit die Warteschlange nicht blockiert
+      uplinkDropHead();
+      uplinkDropped++;
+      rejected = 0;
+      failures = 0;
+      uplinkBackoffMs = 0;
+      continue;
+    }
+
+    // Netzwerkfehler, 5xx oder erneute Ablehnung: exponentiell länger warten, gedeckelt
+    lastFailure = millis();
+    if (failures < 255) failures++;
+    uplinkBackoffMs = uplinkBackoff(failures);
+  }
+
+  delete batch;
+  vTaskDelete(nullptr);
+}
+
+void handleGetUplink() {
+  String json = "{";
+  json += "\"enabled\":" + String(uplinkConfig.enabled ? "true" : "false") + ",";
+  json += "\"ssid\":" + jsonString(uplinkConfig.staSsid) + ",";
+  json += "\"url\":" + jsonString(uplinkConfig.collectorUrl) + ",";
+  json += "\"station\":" + jsonString(uplinkConfig.stationId) + ",";
+  json += "\"batch\":" + String(uplinkConfig.batchSeconds) + ",";
+  json += "\"gzip\":" + String(uplinkConfig.gzip ? "true" : "false") + ",";
+  json += "\"connected\":" + String(WiFi.status() == WL_CONNECTED ? "true" : "false") + ",";
+  xSemaphoreTake(uplinkConfigMutex, portMAX_DELAY);   // Zähler schreibt der Uplink-Task
+  uint32_t queued = uplinkNextSeq - uplinkHeadSeq;
+  xSemaphoreGive(uplinkConfigMutex);
+  json += "\"queued\":" + String(queued) + ",";
+  json += "\"backoffMs\":" + String(uplinkBackoffMs) + ",";
+  json += "\"sent\":" + String(uplinkSent) + ",";
+  json += "\"dropped\":" + String(uplinkDropped) + ",";
+  json += "\"lastStatus\":" + String(uplinkLastStatus);
+  json += "}";
+  server.send(200, "application/json", json);
+}
+
+// POST /api/uplink mit JSON, z.B. {"enabled":true,"ssid":"Labor","password":"...","url":"http://...","batch":60}
+void handleSetUplink() {
+  if (!server.hasArg("plain")) {
+    server.send(400, "text/plain", "Keine Daten empfangen");
+    return;
+  }
+  DynamicJsonDocument doc(512);
+  if (deserializeJson(doc, server.arg("plain"))) {
+    server.send(400, "text/plain", "Ungültiges JSON");
+    return;
+  }
+
+  bool wasEnabled = uplinkConfig.enabled;
+  xSemaphoreTake(uplinkConfigMutex, portMAX_DELAY);   // der Uplink-Task liest die Strings gleichzeitig
+  if (doc.containsKey("enabled"))  uplinkConfig.enabled = doc["enabled"];
+  if (doc.containsKey("ssid"))     uplinkConfig.staSsid = doc["ssid"].as<String>();
+  if (doc.containsKey("password")) uplinkConfig.staPassword = doc["password"].as<String>();
+  if (doc.containsKey("url"))      uplinkConfig.collectorUrl = doc["url"].as<String>();
+  if (doc.containsKey("station"))  uplinkConfig.stationId = doc["station"].as<String>();
+  if (doc.containsKey("gzip"))     uplinkConfig.gzip = doc["gzip"];
+  if (doc.containsKey("batch")) {
+    int batch = doc["batch"];
+    if (batch >= 1 && batch <= UPLINK_MAX_SAMPLES) uplinkConfig.batchSeconds = batch;
+  }
+  xSemaphoreGive(uplinkConfigMutex);
+
+  uplinkPrefs.putBool("enabled", uplinkConfig.enabled);
+  uplinkPrefs.putString("ssid", uplinkConfig.staSsid);
+  uplinkPrefs.putString("pass", uplinkConfig.staPassword);
+  uplinkPrefs.putString("url", uplinkConfig.collectorUrl);
+  uplinkPrefs.putString("station", uplinkConfig.stationId);
+  uplinkPrefs.putUInt("batch", uplinkConfig.batchSeconds);
+  uplinkPrefs.putBool("gzip", uplinkConfig.gzip);
+
+  if (uplinkConfig.enabled) {
+    WiFi.mode(WIFI_AP_STA);
+    startUplink();
+  } else if (wasEnabled) {
+    stopUplink();
+  }
+  server.send(200, "application/json", "{\"status\":\"success\"}");
+}
+
+/* ====================================================
+ * 13. Ereigniserkennung: Regeln, Ereignisprotokoll, Alarmausgang
+ * ==================================================== */
+// Namen der Regeltypen in der JSON-API (Reihenfolge wie EventRuleType)
+const char* const eventRuleTypeNames[RULE_TYPE_COUNT] = {"above", "below", "rise", "drop", "diff", "flowNoPressure"};
+
+bool eventRuleValid(const EventRule& rule) {
+  return rule.type < RULE_TYPE_COUNT && rule.a < EVENT_CHANNELS && rule.b < EVENT_CHANNELS &&
+         rule.hold >= 1 && rule.window >= 1 && rule.window <= EVENT_RATE_WINDOW &&
+         memchr(rule.name, '\0', sizeof(rule.name)) != nullptr &&
+         !isnan(rule.threshold) && !isnan(rule.threshold2) && !isnan(rule.hysteresis) && rule.hysteresis >= 0;
+}
+
+void loadEventRules() {
+  eventPrefs.begin("events", false);
+  // Fehlt die Tabelle oder hat sie eine andere Größe (ältere Firmware), sind alle Regeln aus
+  if (eventPrefs.getBytes("rules", eventRules, sizeof(eventRules)) != sizeof(eventRules)) {
+    memset(eventRules, 0, sizeof(eventRules));
+  }
+  for (uint8_t r = 0; r < EVENT_RULES_MAX; r++) {
+    if (!eventRuleValid(eventRules[r])) {
+      memset(&eventRules[r], 0, sizeof(EventRule));
+      eventRules[r].hold = 1;
+      eventRules[r].window = 1;
+    }
+  }
+  memset(eventState, 0, sizeof(eventState));
+}
+
+// Wertet die Bedingung einer Regel aus: raise = Ereignis auslösen, clear = Ereignis beenden (mit Hysterese).
+// Rückgabe false, solange der Verlauf für eine Änderungsrate noch zu kurz ist.
+bool eventCondition(const EventRule& rule, const float* values, float& value, bool& raise, bool& clear) {
+  float threshold = rule.threshold;
+  float hysteresis = rule.hysteresis;
+  switch (rule.type) {
+    case RULE_BELOW:
+      value = values[rule.a];
+      raise = value < threshold;
+      clear = value >= threshold + hysteresis;
+      return true;
+
+    case RULE_RISE:
+    case RULE_DROP: {
+      if (eventHistoryCount <= rule.window) return false;
+      uint8_t past = (eventHistoryIndex + EVENT_RATE_WINDOW + 1 - rule.window) % (EVENT_RATE_WINDOW + 1);
+      value = (values[rule.a] - eventHistory[rule.a][past]) / rule.window;  // pro Messzyklus = pro Sekunde
+      if (rule.type == RULE_DROP) value = -value;                          // Abfall als positive Rate
+      break;
+    }
+
+    case RULE_DIFF:
+      value = values[rule.a] - values[rule.b];
+      break;
+
+    case RULE_FLOW_NO_PRESSURE:
+      value = values[rule.a];
+      raise = value > threshold && values[rule.b] < rule.threshold2;
+      clear = value <= threshold - hysteresis || values[rule.b] >= rule.threshold2 + hysteresis;
+      return true;
+
+    default:                                   // RULE_ABOVE
+      value = values[rule.a];
+      break;
+  }
+  raise = value > threshold;
+  clear = value <= threshold - hysteresis;
+  return true;
+}
+
+void recordEvent(uint8_t rule, bool active, float value, time_t t) {
+  eventLastId++;
+  EventRecord& e = eventLog[eventLastId % EVENT_LOG_SIZE];
+  e.id = eventLastId;
+  e.time = t;
+  e.rule = rule;
+  e.active = active;
+  e.value = value;
+  e.latencyUs = 0;
+  e.deliveryMs = 0;
+  e.createdMillis = millis();
+}
+
+// Wird in jedem Messzyklus aufgerufen: O(1) je Regel, kein Flash, kein Netzwerk
+void evaluateEvents(const float* values, uint32_t sampleStartUs) {
+  uint32_t evalStartUs = micros();
+
+  // Verlauf für Änderungsraten fortschreiben (ein Eintrag pro Messzyklus)
+  eventHistoryIndex = (eventHistoryIndex + 1) % (EVENT_RATE_WINDOW + 1);
+  for (uint8_t c = 0; c < EVENT_CHANNELS; c++) {
+    eventHistory[c][eventHistoryIndex] = values[c];
+  }
+  if (eventHistoryCount <= EVENT_RATE_WINDOW) eventHistoryCount++;
+
+  uint32_t firstNewId = eventLastId + 1;
+  time_t now = time(nullptr);
+  bool output = false;
+  for (uint8_t r = 0; r < EVENT_RULES_MAX; r++) {
+    const EventRule& rule = eventRules[r];
+    EventRuleState& state = eventState[r];
+    if (!rule.enabled) continue;
+
+    float value;
+    bool raise, clear;
+    if (!eventCondition(rule, values, value, raise, clear)) continue;
+
+    // Entprellung: Auslösen bzw. Beenden erst, wenn es "hold" Messzyklen in Folge ansteht
+    bool pending = state.active ? clear : raise;
+    state.count = pending ? state.count + 1 : 0;
+    if (state.count >= rule.hold) {
+      state.active = !state.active;
+      state.count = 0;
+      recordEvent(r, state.active, value, now);
+    }
+
+    if (state.active) {
+      eventActiveMask |= (1 << r);
+      if (rule.output) output = true;
+    } else {
+      eventActiveMask &= ~(1 << r);
+    }
+  }
+  digitalWrite(EVENT_OUTPUT_PIN, output ? HIGH : LOW);
+
+  // Latenz erst jetzt eintragen: Ereignis erfasst und Alarmausgang geschaltet
+  uint32_t endUs = micros();
+  for (uint32_t id = firstNewId; id <= eventLastId; id++) {
+    EventRecord& e = eventLog[id % EVENT_LOG_SIZE];
+    e.latencyUs = endUs - sampleStartUs;
+    if (e.latencyUs > eventLatencyUsMax) eventLatencyUsMax = e.latencyUs;
+  }
+  eventEvalUs = endUs - evalStartUs;
+  if (eventEvalUs > eventEvalUsMax) eventEvalUsMax = eventEvalUs;
+}
+
+// Hängt neue Ereignisse an das Protokoll im SPIFFS an (Format wie die Logdateien: Semikolon, Dezimalkomma)
+void persistEvents() {
+  // Ereignisse, die der Ringpuffer schon überschrieben hat, können nicht mehr geschrieben werden
+  if (eventLastId - eventPersistedId > EVENT_LOG_SIZE) eventPersistedId = eventLastId - EVENT_LOG_SIZE;
+
+  File file = SPIFFS.open(EVENT_FILE, FILE_APPEND);
+  if (file && file.size() > EVENT_FILE_MAX) {
+    file.close();
+    SPIFFS.remove(EVENT_FILE_OLD);
+    SPIFFS.rename(EVENT_FILE, EVENT_FILE_OLD);
+    file = SPIFFS.open(EVENT_FILE, FILE_APPEND);
+  }
+  if (!file) {
+    eventPersistedId = eventLastId;            // nicht in jedem Messzyklus erneut versuchen
+    return;
+  }
+  if (file.size() == 0) {
+    file.print("Zeitstempel;Regel;Name;Zustand;Wert;Latenz (us)\n");
+  }
+
+  for (uint32_t id = eventPersistedId + 1; id <= eventLastId; id++) {
+    const EventRecord& e = eventLog[id % EVENT_LOG_SIZE];
+    char timeBuf[24];
+    formatTimestamp(e.time, timeBuf, sizeof(timeBuf));
+    char value[16];
+    snprintf(value, sizeof(value), "%.3f", e.value);
+    char* dot = strchr(value, '.');
+    if (dot) *dot = ',';
+    char line[96];
+    int len = snprintf(line, sizeof(line), "%s;%u;%s;%s;%s;%lu\n", timeBuf,
+                       (unsigned)e.rule + 1, eventRules[e.rule].name, e.active ? "ausgelöst" : "beendet",
+                       value, (unsigned long)e.latencyUs);
+    if (len > 0) file.write((const uint8_t*)line, len < (int)sizeof(line) ? len : sizeof(line) - 1);
+  }
+  file.close();
+  eventPersistedId = eventLastId;
+}
+
+// Ein Ereignis als JSON-Objekt (für /api/events und den SSE-Stream)
+String eventJson(const EventRecord& e) {
+  char timeBuf[24];
+  formatTimestamp(e.time, timeBuf, sizeof(timeBuf));
+  String json = "{\"id\":" + String(e.id) + ",\"time\":\"" + timeBuf + "\",\"rule\":" + String(e.rule);
+  json += ",\"name\":" + jsonString(eventRules[e.rule].name);
+  json += ",\"active\":" + String(e.active ? "true" : "false");
+  json += ",\"value\":" + String(e.value, 3);
+  json += ",\"latencyUs\":" + String(e.latencyUs) + ",\"deliveryMs\":" + String(e.deliveryMs) + "}";
+  return json;
+}
+
+// Erstes noch vorhandenes Ereignis nach <since>; eventLastId + 1, wenn es nichts Neues gibt
+uint32_t firstEventAfter(uint32_t since) {
+  uint32_t first = eventLastId >= EVENT_LOG_SIZE ? eventLastId - EVENT_LOG_SIZE + 1 : 1;
+  if (since >= eventLastId) return eventLastId + 1;
+  return since >= first ? since + 1 : first;
+}
+
+// /api/events[?since=<id>] – Ereignisse mit größerer Nummer (älteste zuerst), aktive Regeln und Latenzen.
+// Reines Lesen: deliveryMs setzt nur der Push über /api/events/stream.
+void handleGetEvents() {
+  uint32_t since = server.hasArg("since") ? strtoul(server.arg("since").c_str(), nullptr, 10) : 0;
+  uint32_t first = firstEventAfter(since);     // since aus einem früheren Start: nichts Neues
+
+  String json;
+  json.reserve(256 + (eventLastId + 1 - first) * 160);
+  json += "{\"lastId\":" + String(eventLastId) + ",\"active\":" + String(eventActiveMask) + ",\"events\":[";
+  for (uint32_t id = first; id <= eventLastId; id++) {
+    if (id != first) json += ",";
+    json += eventJson(eventLog[id % EVENT_LOG_SIZE]);
+  }
+  json += "],\"evalUs\":" + String(eventEvalUs) + ",\"evalUsMax\":" + String(eventEvalUsMax);
+  json += ",\"latencyUsMax\":" + String(eventLatencyUsMax) + ",\"deliveryMsMax\":" + String(eventDeliveryMsMax) + "}";
+  server.send(200, "application/json", json);
+}
+
+// Ein Ereignis als SSE-Nachricht; false, wenn die Verbindung es nicht mehr annimmt
+bool writeEventFrame(WiFiClient& client, const EventRecord& e) {
+  String frame = "id: " + String(e.id) + "\ndata: " + eventJson(e) + "\n\n";
+  return client.write((const uint8_t*)frame.c_str(), frame.length()) == frame.length();
+}
+
+// /api/events/stream[?since=<id>] – hält die Verbindung offen (text/event-stream).
+// Der Handler antwortet selbst auf dem Socket und behält eine Kopie des Clients,
+// der WebServer gibt danach nur seine eigene Referenz frei.
+// Nach einer Unterbrechung schickt der Browser Last-Event-ID: Verpasstes kommt aus dem Ringpuffer.
+void handleEventStream() {
+  uint8_t slot = EVENT_STREAM_CLIENTS;
+  for (uint8_t i = 0; i < EVENT_STREAM_CLIENTS; i++) {
+    if (!eventStreamClients[i].connected()) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot == EVENT_STREAM_CLIENTS) {
+    server.sendHeader("Retry-After", "30");
+    server.send(503, "text/plain", "Zu viele Ereignis-Streams");   // Webseite fragt dann /api/events ab
+    return;
+  }
+
+  String last = server.hasHeader("Last-Event-ID") ? server.header("Last-Event-ID") : server.arg("since");
+  uint32_t since = strtoul(last.c_str(), nullptr, 10);
+  if (since > eventLastId) since = 0;          // Station wurde neu gestartet: alles noch Vorhandene schicken
+
+  WiFiClient client = server.client();
+  client.setNoDelay(true);
+  client.print("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+               "Connection: keep-alive\r\n\r\nretry: 2000\n\n");
+  for (uint32_t id = firstEventAfter(since); id <= eventLastId; id++) {
+    if (!writeEventFrame(client, eventLog[id % EVENT_LOG_SIZE])) return;
+  }
+  eventStreamClients[slot] = client;
+}
+
+// Aus dem Messzyklus direkt nach evaluateEvents(): neue Ereignisse an alle offenen Streams.
+// Die Nachrichten sind klein (< 200 Byte) und passen ins TCP-Sendefenster; eine Verbindung,
+// die nichts mehr annimmt, wird geschlossen. Der erste erfolgreiche Push legt deliveryMs fest.
+void pushEvents() {
+  unsigned long now = millis();
+  if (eventLastId - eventPushedId > EVENT_LOG_SIZE) eventPushedId = eventLastId - EVENT_LOG_SIZE;
+  bool ping = now - eventStreamLastWrite >= EVENT_STREAM_PING_MS;
+  if (eventPushedId == eventLastId && !ping) return;
+
+  for (uint32_t id = eventPushedId + 1; id <= eventLastId; id++) {
+    EventRecord& e = eventLog[id % EVENT_LOG_SIZE];
+    bool delivered = false;
+    for (uint8_t i = 0; i < EVENT_STREAM_CLIENTS; i++) {
+      WiFiClient& client = eventStreamClients[i];
+      if (!client.connected()) continue;
+      if (writeEventFrame(client, e)) delivered = true;
+      else client.stop();
+    }
+    if (delivered && e.deliveryMs == 0) {
+      e.deliveryMs = millis() - e.createdMillis + e.latencyUs / 1000 + 1;   // +1: 0 steht für "nicht per Push"
+      if (e.deliveryMs > eventDeliveryMsMax) eventDeliveryMsMax = e.deliveryMs;
+    }
+  }
+  eventPushedId = eventLastId;
+
+  if (ping) {
+    for (uint8_t i = 0; i < EVENT_STREAM_CLIENTS; i++) {
+      WiFiClient& client = eventStreamClients[i];
+      if (client.connected() && client.print(": ping\n\n") == 0) client.stop();
+    }
+  }
+  eventStreamLastWrite = now;
+}
+
+void handleGetEventRules() {
+  String json = "[";
+  for (uint8_t r = 0; r < EVENT_RULES_MAX; r++) {
+    const EventRule& rule = eventRules[r];
+    if (r > 0) json += ",";
+    json += "{\"index\":" + String(r);
+    json += ",\"enabled\":" + String(rule.enabled ? "true" : "false");
+    json += ",\"type\":\"" + String(eventRuleTypeNames[rule.type]) + "\"";
+    json += ",\"a\":" + String(rule.a) + ",\"b\":" + String(rule.b);
+    json += ",\"threshold\":" + String(rule.threshold, 3);
+    json += ",\"threshold2\":" + String(rule.threshold2, 3);
+    json += ",\"hysteresis\":" + String(rule.hysteresis, 3);
+    json += ",\"hold\":" + String(rule.hold) + ",\"window\":" + String(rule.window);
+    json += ",\"output\":" + String(rule.output ? "true" : "false");
+    json += ",\"name\":" + jsonString(rule.name);
+    json += ",\"active\":" + String(eventState[r].active ? "true" : "false") + "}";
+  }
+  json += "]";
+  server.send(200, "application/json", json);
+}
+
+// POST /api/rules mit JSON, z.B. {"index":0,"enabled":true,"type":"drop","a":0,"threshold":0.2,"window":5,"hold":2,"output":true,"name":"Druckabfall 1"}
+// Nicht angegebene Felder behalten ihren Wert.
+void handleSetEventRule() {
+  if (!server.hasArg("plain")) {
+    server.send(400, "text/plain", "Keine Daten empfangen");
+    return;
+  }
+  DynamicJsonDocument doc(512);
+  if (deserializeJson(doc, server.arg("plain"))) {
+    server.send(400, "text/plain", "Ungültiges JSON");
+    return;
+  }
+  int index = doc.containsKey("index") ? (int)doc["index"] : -1;
+  if (index < 0 || index >= EVENT_RULES_MAX) {
+    server.send(400, "text/plain", "Ungültiger Regelindex");
+    return;
+  }
+
+  EventRule rule = eventRules[index];
+  if (doc.containsKey("enabled"))    rule.enabled = doc["enabled"];
+  if (doc.containsKey("a"))          rule.a = (int)doc["a"];
+  if (doc.containsKey("b"))          rule.b = (int)doc["b"];
+  if (doc.containsKey("threshold"))  rule.threshold = doc["threshold"];
+  if (doc.containsKey("threshold2")) rule.threshold2 = doc["threshold2"];
+  if (doc.containsKey("hysteresis")) rule.hysteresis = doc["hysteresis"];
+  if (doc.containsKey("hold"))       rule.hold = constrain((int)doc["hold"], 0, 255);
+  if (doc.containsKey("window"))     rule.window = constrain((int)doc["window"], 0, 255);
+  if (doc.containsKey("output"))     rule.output = doc["output"];
+  if (doc.containsKey("type")) {
+    String type = doc["type"].as<String>();
+    rule.type = RULE_TYPE_COUNT;
+    for (uint8_t t = 0; t < RULE_TYPE_COUNT; t++) {
+      if (type == eventRuleTypeNames[t]) rule.type = t;
+    }
+  }
+  if (doc.containsKey("name")) {
+    String name = doc["name"].as<String>();
+    name.replace("\"", "'");                   // Name wird ungeprüft in JSON und CSV ausgegeben
+    name.replace("\\", "/");
+    name.replace(";", ",");
+    strncpy(rule.name, name.c_str(), sizeof(rule.name) - 1);
+    rule.name[sizeof(rule.name) - 1] = '\0';
+  }
+  if (!eventRuleValid(rule)) {
+    server.send(400, "text/plain", "Ungültige Regel");
+    return;
+  }
+
+  // Geänderte Regel beginnt ohne Zustand; der Alarmausgang folgt im nächsten Messzyklus
+  eventRules[index] = rule;
+  eventState[index] = {false, 0};
+  eventActiveMask &= ~(1 << index);
+  eventPrefs.putBytes("rules", eventRules, sizeof(eventRules));
+  stateVersion++;
+  server.send(200, "application/json", "{\"status\":\"success\"}");
+}
+
+/* ====================================================
+ * 14. Kennwerte: Sitzungs- und Fensterstatistik, abgeleitete Kanäle
+ * ==================================================== */
+// Wert eines Kanals aus einem Eintrag des 10-Minuten-Puffers; false = nicht vorhanden
+bool statsValue(const SensorData& d, uint8_t ch, float& value) {
+  if (d.timestamp == 0) return false;
+  switch (ch) {
+    case 0: case 1: case 2: case 3:
+      value = d.pressure[ch];
+      break;
+    case 4:
+      value = d.flowRate1;
+      break;
+    case 5:
+      value = d.flowRate2;
+      break;
+    case 6:
+      value = d.pressure[0] - d.pressure[1];
+      break;
+    case 7:
+      value = d.pressure[2] - d.pressure[3];
+      break;
+    case 8:
+      if (d.flowRate1 < STATS_PPF_MIN_FLOW) return false;
+      value = (d.pressure[0] - d.pressure[1]) / d.flowRate1;
+      break;
+    case 9:
+      if (d.flowRate2 < STATS_PPF_MIN_FLOW) return false;
+      value = (d.pressure[2] - d.pressure[3]) / d.flowRate2;
+      break;
+    default:
+      return false;
+  }
+  return !isnan(value);
+}
+
+// --- P²-Quantilschätzer ---
+void p2Init(P2Quantile& s, float p) {
+  memset(&s, 0, sizeof(s));
+  s.p = p;
+}
+
+void p2Add(P2Quantile& s, float x) {
+  // Die ersten fünf Werte sortiert sammeln, danach stehen die Marker
+  if (s.count < 5) {
+    int i = s.count++;
+    while (i > 0 && s.q[i - 1] > x) {
+      s.q[i] = s.q[i - 1];
+      i--;
+    }
+    s.q[i] = x;
+    if (s.count == 5) {
+      for (int m = 0; m < 5; m++) s.n[m] = m;
+      s.np[0] = 0;
+      s.np[1] = 2 * s.p;
+      s.np[2] = 4 * s.p;
+      s.np[3] = 2 + 2 * s.p;
+      s.np[4] = 4;
+    }
+    return;
+  }
+
+  // Zelle k mit q[k] <= x < q[k+1] finden, Extremwerte anpassen
+  int k;
+  if (x < s.q[0]) {
+    s.q[0] = x;
+    k = 0;
+  } else if (x >= s.q[4]) {
+    s.q[4] = x;
+    k = 3;
+  } else {
+    k = 0;
+    while (x >= s.q[k + 1]) k++;
+  }
+  for (int m = k + 1; m < 5; m++) s.n[m]++;
+  const double dn[5] = {0, s.p / 2, s.p, (1 + s.p) / 2, 1};
+  for (int m = 0; m < 5; m++) s.np[m] += dn[m];
+  s.count++;
+
+  // Mittlere Marker nachführen (parabolisch, sonst linear)
+  for (int m = 1; m < 4; m++) {
+    double d = s.np[m] - s.n[m];
+    if ((d >= 1 && s.n[m + 1] - s.n[m] > 1) || (d <= -1 && s.n[m - 1] - s.n[m] < -1)) {
+      int sign = d >= 0 ? 1 : -1;
+      double qm = s.q[m], qUp = s.q[m + 1], qDown = s.q[m - 1];
+      double nm = s.n[m], nUp = s.n[m + 1], nDown = s.n[m - 1];
+      double parabolic = qm + sign / (nUp - nDown) *
+                         ((nm - nDown + sign) * (qUp - qm) / (nUp - nm) + (nUp - nm - sign) * (qm - qDown) / (nm - nDown));
+      if (qDown < parabolic && parabolic < qUp) {
+        s.q[m] = parabolic;
+      } else {
+        s.q[m] = qm + sign * (s.q[m + sign] - qm) / (s.n[m + sign] - nm);
+      }
+      s.n[m] += sign;
+    }
+  }
+}
+
+float p2Value(const P2Quantile& s) {
+  if (s.count == 0) return NAN;
+  if (s.count < 5) return s.q[(int)(s.p * (s.count - 1) + 0.5f)];   // exakt aus den sortierten Werten
+  return s.q[2];
+}
+
+// --- Gleitende Fenster ---
+// Nimmt den Wert an Position pos auf und rechnet den Wert heraus, der das Fenster verlässt (len Messzyklen alt).
+// evict = false beim Neuaufbau: dort war der ältere Wert nie im Fenster.
+void windowAdd(WindowStats& w, uint16_t len, uint8_t ch, uint16_t pos, bool evict) {
+  float x;
+  if (evict && w.n > 0 && statsValue(dataBuffer[(pos + BUFFER_SIZE - len) % BUFFER_SIZE], ch, x)) {
+    if (w.n == 1) {
+      w.mean = 0;
+      w.m2 = 0;
+    } else {
+      double delta = x - w.mean;
+      w.mean -= delta / (w.n - 1);
+      w.m2 -= delta * (x - w.mean);
+      if (w.m2 < 0) w.m2 = 0;                  // Rundungsfehler
+    }
+    w.n--;
+  }
+
+  // Abgelaufene Positionen vorne aus den Deques entfernen
+  auto age = [pos](uint16_t p) { return (pos + BUFFER_SIZE - p) % BUFFER_SIZE; };
+  while (w.minQ.size > 0 && age(w.minQ.front()) >= len) w.minQ.popFront();
+  while (w.maxQ.size > 0 && age(w.maxQ.front()) >= len) w.maxQ.popFront();
+
+  if (!statsValue(dataBuffer[pos], ch, x)) return;
+  w.n++;
+  double delta = x - w.mean;
+  w.mean += delta / w.n;
+  w.m2 += delta * (x - w.mean);
+
+  // Werte, die nie mehr Minimum bzw. Maximum werden können, hinten verwerfen
+  float y;
+  while (w.minQ.size > 0 && (!statsValue(dataBuffer[w.minQ.back()], ch, y) || y >= x)) w.minQ.popBack();
+  w.minQ.pushBack(pos);
+  while (w.maxQ.size > 0 && (!statsValue(dataBuffer[w.maxQ.back()], ch, y) || y <= x)) w.maxQ.popBack();
+  w.maxQ.pushBack(pos);
+}
+
+void resetSessionStats() {
+  for (uint8_t ch = 0; ch < STATS_CHANNELS; ch++) {
+    SessionStats& s = statsSession[ch];
+    s.n = 0;
+    s.mean = 0;
+    s.m2 = 0;
+    s.min = NAN;
+    s.max = NAN;
+    for (uint8_t q = 0; q < STATS_QUANTILES; q++) p2Init(s.quantiles[q], statsQuantiles[q]);
+  }
+  statsSessionStart = time(nullptr);
+  stateVersion++;
+}
+
+// Fensterlängen aus dem NVS; ungültige oder fehlende Werte => Standard (1 und 5 Minuten)
+void loadStatsWindows() {
+  statsPrefs.begin("stats", false);
+  uint16_t prev = 0;
+  bool valid = true;
+  for (uint8_t w = 0; w < STATS_WINDOWS; w++) {
+    char key[4] = {'w', (char)('0' + w), '\0'};
+    statsWindowLen[w] = statsPrefs.getUInt(key, statsWindowDefaults[w]);
+    if (statsWindowLen[w] < STATS_WINDOW_MIN || statsWindowLen[w] > STATS_WINDOW_MAX || statsWindowLen[w] <= prev) valid = false;
+    prev = statsWindowLen[w];
+  }
+  if (!valid) memcpy(statsWindowLen, statsWindowDefaults, sizeof(statsWindowLen));
+}
+
+void rebuildWindowStats() {
+  memset(statsWindows, 0, sizeof(statsWindows));
+  // Die letzten Einträge des längsten Fensters vor bufferIndex in zeitlicher Reihenfolge aufnehmen
+  for (int age = statsWindowLen[STATS_WINDOWS - 1] - 1; age >= 0; age--) {
+    uint16_t pos = (bufferIndex + BUFFER_SIZE - 1 - age) % BUFFER_SIZE;
+    for (uint8_t w = 0; w < STATS_WINDOWS; w++) {
+      if (age >= statsWindowLen[w]) continue;
+      for (uint8_t ch = 0; ch < STATS_CHANNELS; ch++) windowAdd(statsWindows[w][ch], statsWindowLen[w], ch, pos, false);
+    }
+  }
+}
+
+void updateStats(uint16_t pos) {
+  for (uint8_t ch = 0; ch < STATS_CHANNELS; ch++) {
+    for (uint8_t w = 0; w < STATS_WINDOWS; w++) windowAdd(statsWindows[w][ch], statsWindowLen[w], ch, pos, true);
+
+    float x;
+    if (!statsValue(dataBuffer[pos], ch, x)) continue;
+    SessionStats& s = statsSession[ch];
+    s.n++;
+    double delta = x - s.mean;
+    s.mean += delta / s.n;
+    s.m2 += delta * (x - s.mean);
+    if (s.n == 1 || x < s.min) s.min = x;
+    if (s.n == 1 || x > s.max) s.max = x;
+    for (uint8_t q = 0; q < STATS_QUANTILES; q++) p2Add(s.quantiles[q], x);
+  }
+}
+
+// Hängt eine Zahl an; fehlende Werte (NAN) als null
+void appendStatNumber(String& json, double value, uint8_t decimals) {
+  if (isnan(value)) json += "null";
+  else json += String(value, (unsigned int)decimals);
+}
+
+void appendWindowStats(String& json, const WindowStats& w, uint8_t ch) {
+  float min = NAN, max = NAN;
+  if (w.minQ.size > 0) statsValue(dataBuffer[w.minQ.front()], ch, min);
+  if (w.maxQ.size > 0) statsValue(dataBuffer[w.maxQ.front()], ch, max);
+  uint8_t decimals = statsChannelDecimals[ch];
+  json += "[";
+  appendStatNumber(json, w.n > 0 ? w.mean : NAN, decimals);
+  json += ",";
+  appendStatNumber(json, w.n > 1 ? sqrt(w.m2 / (w.n - 1)) : NAN, decimals + 1);
+  json += ",";
+  appendStatNumber(json, min, decimals);
+  json += ",";
+  appendStatNumber(json, max, decimals);
+  json += "]";
+}
+
+void handleStats() {
+  sendCachedJson(statsCache, buildStatsJson);
+}
+
+// POST /api/stats {"w0":60,"w1":300} – Fensterlängen in Messzyklen (aufsteigend, STATS_WINDOW_MIN..
+// STATS_WINDOW_MAX, fehlende bleiben). Die Fenster werden sofort aus dataBuffer neu aufgebaut.
+void handleSetStats() {
+  if (!server.hasArg("plain")) {
+    server.send(400, "text/plain", "Keine Daten empfangen");
+    return;
+  }
+  DynamicJsonDocument doc(256);
+  if (deserializeJson(doc, server.arg("plain"))) {
+    server.send(400, "text/plain", "Ungültiges JSON");
+    return;
+  }
+  uint16_t len[STATS_WINDOWS];
+  uint16_t prev = 0;
+  for (uint8_t w = 0; w < STATS_WINDOWS; w++) {
+    char key[4] = {'w', (char)('0' + w), '\0'};
+    int value = doc.containsKey(key) ? (int)doc[key] : statsWindowLen[w];
+    if (value < STATS_WINDOW_MIN || value > STATS_WINDOW_MAX || value <= prev) {
+      server.send(400, "text/plain", "Fensterlängen müssen aufsteigend zwischen " + String(STATS_WINDOW_MIN) +
+                                     " und " + String(STATS_WINDOW_MAX) + " Messzyklen liegen");
+      return;
+    }
+    len[w] = value;
+    prev = value;
+  }
+
+  if (memcmp(len, statsWindowLen, sizeof(len)) != 0) {
+    memcpy(statsWindowLen, len, sizeof(statsWindowLen));
+    for (uint8_t w = 0; w < STATS_WINDOWS; w++) {
+      char key[4] = {'w', (char)('0' + w), '\0'};
+      statsPrefs.putUInt(key, statsWindowLen[w]);
+    }
+    rebuildWindowStats();
+    stateVersion++;
+  }
+  server.send(200, "application/json", "{\"status\":\"success\"}");
+}
+
+// {"since":"...","windows":[60,300],"channels":{"p1":{"n":..,"mean":..,"std":..,"min":..,"max":..,
+//   "p50":..,"p90":..,"p99":..,"w60":[mean,std,min,max],"w300":[...]},...}}
+String buildStatsJson() {
+  char timeBuf[24];
+  formatTimestamp(statsSessionStart, timeBuf, sizeof(timeBuf));
+
+  String json;
+  json.reserve(STATS_CHANNELS * 180 + 96);
+  json += "{\"since\":\"" + String(timeBuf) + "\",\"windows\":[";
+  for (uint8_t w = 0; w < STATS_WINDOWS; w++) {
+    if (w > 0) json += ",";
+    json += String(statsWindowLen[w]);
+  }
+  json += "],\"channels\":{";
+  for (uint8_t ch = 0; ch < STATS_CHANNELS; ch++) {
+    const SessionStats& s = statsSession[ch];
+    uint8_t decimals = statsChannelDecimals[ch];
+    if (ch > 0) json += ",";
+    json += "\"" + String(statsChannelNames[ch]) + "\":{\"n\":" + String(s.n) + ",\"mean\":";
+    appendStatNumber(json, s.n > 0 ? s.mean : NAN, decimals);
+    json += ",\"std\":";
+    appendStatNumber(json, s.n > 1 ? sqrt(s.m2 / (s.n - 1)) : NAN, decimals + 1);
+    json += ",\"min\":";
+    appendStatNumber(json, s.min, decimals);
+    json += ",\"max\":";
+    appendStatNumber(json, s.max, decimals);
+    for (uint8_t q = 0; q < STATS_QUANTILES; q++) {
+      json += ",\"p" + String((int)(statsQuantiles[q] * 100 + 0.5f)) + "\":";
+      appendStatNumber(json, p2Value(s.quantiles[q]), decimals);
+    }
+    for (uint8_t w = 0; w < STATS_WINDOWS; w++) {
+      json += ",\"w" + String(statsWindowLen[w]) + "\":";
+      appendWindowStats(json, statsWindows[w][ch], ch);
+    }
+    json += "}";
+  }
+  json += "}}";
+  return json;
+}
+
+void handleResetStats() {
+  resetSessionStats();
+  server.send(200, "text/plain", "Kennwerte zurückgesetzt");
+}
+
+/* ====================================================
+ * 15. Start in Stufen: Teilsysteme, Wiederholversuche, /api/health
+ * ==================================================== */
+void subsystemResult(SubsystemId id, bool ok, const char* error) {
+  Subsystem& sub = subsystems[id];
+  sub.attempts++;
+  if (ok) {
+    sub.readyMs = millis();
+    sub.retryMs = 0;                           // fällt es später aus, beginnt der Backoff wieder kurz
+    sub.error = nullptr;
+    sub.state = SUB_OK;                        // zuletzt setzen: andere Tasks fragen nur state ab
+    Serial.printf("Start: %s bereit nach %lu ms\n", subsystemNames[id], (unsigned long)sub.readyMs);
+    return;
+  }
+  // Wartezeit verdoppeln (Backoff), damit ein fehlendes Teilsystem loop() nicht ausbremst
+  sub.retryMs = sub.retryMs == 0 ? BOOT_RETRY_MIN_MS : sub.retryMs * 2;
+  if (sub.retryMs > BOOT_RETRY_MAX_MS) sub.retryMs = BOOT_RETRY_MAX_MS;
+  sub.nextTryMs = millis() + sub.retryMs;
+  sub.error = error;
+  sub.state = SUB_RETRY;
+  Serial.printf("Start: %s – %s, nächster Versuch in %lu ms\n", subsystemNames[id], error, (unsigned long)sub.retryMs);
+}
+
+bool subsystemDue(SubsystemId id) {
+  const Subsystem& sub = subsystems[id];
+  return sub.state == SUB_RETRY && (int32_t)(millis() - sub.nextTryMs) >= 0;
+}
+
+void startAccessPoint() {
+  WiFi.mode(uplinkConfig.enabled ? WIFI_AP_STA : WIFI_AP);
+  WiFi.softAPConfig(local_IP, gateway, subnet);
+  bool ok = WiFi.softAP(ssid, password);
+  if (ok) {
+    Serial.print("Access Point IP: ");
+    Serial.println(WiFi.softAPIP());
+  }
+  subsystemResult(SUB_WIFI, ok, "Access Point konnte nicht gestartet werden");
+}
+
+void startADC() {
+  bool ok = ads.begin(0x48);                   // 0x48 ist die Standardadresse
+  if (ok) ads.setGain(GAIN_ONE);
+  subsystemResult(SUB_ADC, ok, "ADS1115 nicht gefunden (I2C-Adresse 0x48)");
+}
+
+// Kurzer I²C-Adresstest vor jedem Messzyklus: ein abgezogener ADS1115 liefert sonst Fantasiewerte
+bool checkADC() {
+  Wire.beginTransmission(0x48);
+  if (Wire.endTransmission() == 0) return true;
+  subsystemResult(SUB_ADC, false, "ADS1115 antwortet nicht mehr (I2C-Adresse 0x48)");
+  return false;
+}
+
+void fsTask(void* param) {
+  (void)param;
+
+  while (true) {
+    // Mit true wird formatiert, wenn sich das SPIFFS nicht einhängen lässt (z. B. beim ersten Start)
+    bool ok = SPIFFS.begin(true);
+    subsystemResult(SUB_FS, ok, "SPIFFS konnte weder eingehängt noch formatiert werden");
+    if (ok) break;
+    vTaskDelay(pdMS_TO_TICKS(subsystems[SUB_FS].retryMs));
+  }
+  fsTaskHandle = nullptr;
+  vTaskDelete(nullptr);
+}
+
+void serviceSubsystems() {
+  if (subsystemDue(SUB_WIFI)) startAccessPoint();
+  if (subsystemDue(SUB_ADC)) startADC();
+}
+
+bool requireFilesystem() {
+  if (subsystems[SUB_FS].state == SUB_OK) return true;
+  server.sendHeader("Retry-After", "2");
+  server.send(503, "text/plain", "Dateisystem wird vorbereitet, bitte gleich erneut versuchen");
+  return false;
+}
+
+const char* subsystemStateName(SubsystemState state) {
+  switch (state) {
+    case SUB_OK:    return "ok";
+    case SUB_RETRY: return "retry";
+    default:        return "pending";
+  }
+}
+
+// /api/health – z. B.
+// {"uptimeMs":..,"budgetMs":1000,"httpReadyMs":212,"firstRequestMs":640,"firstResponseMs":652,"withinBudget":true,
+//  "degraded":false,"subsystems":{"wifi":{"state":"ok","attempts":1,"readyMs":180,"retryInMs":0,"error":null},...}}
+// withinBudget: Server rechtzeitig bereit, und eine Anfrage aus dem Budget wurde auch darin beantwortet.
+// Kommt die erste Anfrage erst später, zählt ihre Antwortzeit nicht (sie hängt vom Client ab, nicht vom Start).
+void handleHealth() {
+  uint32_t now = millis();
+  bool degraded = false;
+  bool responseInBudget = bootFirstRequestMs == 0 || bootFirstRequestMs > BOOT_BUDGET_MS ||
+                          (bootFirstResponseMs != 0 && bootFirstResponseMs <= BOOT_BUDGET_MS);
+  bool withinBudget = subsystems[SUB_HTTP].readyMs <= BOOT_BUDGET_MS && responseInBudget;
+  String json = "{\"uptimeMs\":" + String(now) + ",\"budgetMs\":" + String(BOOT_BUDGET_MS) + ",";
+  json += "\"httpReadyMs\":" + String(subsystems[SUB_HTTP].readyMs) + ",";
+  json += "\"firstRequestMs\":" + String(bootFirstRequestMs) + ",";
+  json += "\"firstResponseMs\":" + String(bootFirstResponseMs) + ",";
+  json += "\"withinBudget\":" + String(withinBudget ? "true" : "false") + ",";
+  String list = "";
+  for (uint8_t i = 0; i < SUB_COUNT; i++) {
+    const Subsystem& sub = subsystems[i];
+    if (sub.state != SUB_OK) degraded = true;
+    uint32_t retryIn = sub.state == SUB_RETRY && (int32_t)(sub.nextTryMs - now) > 0 ? sub.nextTryMs - now : 0;
+    if (i > 0) list += ",";
+    list += "\"" + String(subsystemNames[i]) + "\":{\"state\":\"" + subsystemStateName(sub.state) + "\",";
+    list += "\"attempts\":" + String(sub.attempts) + ",";
+    list += "\"readyMs\":" + String(sub.state == SUB_OK ? sub.readyMs : 0) + ",";
+    list += "\"retryInMs\":" + String(retryIn) + ",";
+    list += "\"error\":" + (sub.error ? "\"" + String(sub.error) + "\"" : String("null")) + "}";
+  }
+  json += "\"degraded\":" + String(degraded ? "true" : "false") + ",";
+  json += "\"subsystems\":{" + list + "}}";
+  server.sendHeader("Cache-Control", "no-cache");
+  server.send(200, "application/json", json);
+}
+
+// Ersatz für index.html, solange das SPIFFS noch eingehängt wird: zeigt den Zustand und lädt alle 2 s neu
+void handleBootStatus() {
+  String html = "<!DOCTYPE html><html lang=\"de\"><head><meta charset=\"utf-8\">"
+                "<meta http-equiv=\"refresh\" content=\"2\"><title>Messstation startet</title></head><body>"
+                "<h1>Messstation startet</h1><ul>";
+  for (uint8_t i = 0; i < SUB_COUNT; i++) {
+    const Subsystem& sub = subsystems[i];
+    html += "<li>" + String(subsystemNames[i]) + ": ";
+    if (sub.state == SUB_OK)         html += "bereit";
+    else if (sub.state == SUB_RETRY) html += String(sub.error) + " (Versuch " + String(sub.attempts) + ")";
+    else                             html += "startet...";
+    html += "</li>";
+  }
+  html += "</ul><p>Details: <a href=\"/api/health\">/api/health</a></p></body></html>";
+  server.sendHeader("Retry-After", "2");
+  server.send(503, "text/html", html);
+}
@@ -0,0 +1,576 @@
+/*****************************************************
+ * test_main.cpp – Host-Tests der reinen Logik der Firmware
+ *
+ * Übersetzt src/main.cpp wie die Lastsimulation gegen die Ersatz-Header in
+ * tools/loadsim/include und prüft ohne Hardware:
+ *   - parseRange():              Range-Header für /downloadlog
+ *   - DeflateStream:             CRC-32, Deflate, gzip und ZIP (mit zlib entpackt)
+ *   - Totalisator:               Journal im NVS über mehrere Umläufe, Zurücksetzen
+ *   - Warmstart:                 Block-CRCs des No-Init-RAM, beschädigte Blöcke
+ *   - Kennwerte:                 Welford und P² (Sitzung), gleitende Fenster, /api/stats
+ *   - Ereigniserkennung:         Entprellung, Hysterese, fehlende Werte (NAN)
+ *
+ * Ausgabe: je fehlgeschlagener Prüfung Datei:Zeile und Ausdruck,
+ * Rückgabewert 0 = alles bestanden.
+ *
+ * Bauen (zlib nur für die Gegenprobe):
+ *   pio run -e hosttest                     (Programm: .pio/build/hosttest/program)
+ *   oder direkt:
+ *   g++ -O2 -std=gnu++17 -pthread -Itools/loadsim -Itools/loadsim/include -Ilib/LogFormat -Ilib/DeflateStream \
+ *       src/main.cpp test/host/test_main.cpp tools/loadsim/sim_core.cpp tools/loadsim/sim_net.cpp \
+ *       tools/loadsim/sim_storage.cpp lib/LogFormat/LogFormat.cpp lib/DeflateStream/DeflateStream.cpp \
+ *       -lz -o hosttest
+ *****************************************************/
+#include "sim.h"
+
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <WebServer.h>
+#include <DeflateStream.h>
+#include <LogFormat.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+/* ====================================================
+ * Firmware (src/main.cpp)
+ * ==================================================== */
+#define BUFFER_SIZE 600                 // wie in src/main.cpp
+#define TOTALIZER_SLOTS 8               // wie in src/main.cpp
+#define RETAINED_BLOCK 20               // wie in src/main.cpp
+
+struct SensorData {                     // wie in src/main.cpp
+  time_t timestamp;
+  float pressure[4];
+  float flowRate1;
+  float flowRate2;
+};
+
+void setup();
+void loop();
+bool parseRange(const String& header, size_t fileSize, size_t& start, size_t& end);
+void loadTotalizer();
+void commitTotalizer();
+void clearTotalizer();
+void restoreRetainedState();
+void resetSessionStats();
+void rebuildWindowStats();
+void updateStats(uint16_t pos);
+void evaluateEvents(const float* values, uint32_t sampleStartUs);
+extern WebServer server;
+extern SensorData dataBuffer[BUFFER_SIZE];
+extern int bufferIndex;
+extern bool warmRestart;
+extern uint64_t totalPulses1;
+extern uint64_t totalPulses2;
+extern uint64_t committedPulses[2];
+extern uint32_t totalizerSeq;
+extern uint32_t stateVersion;
+extern uint32_t eventLastId;
+extern uint8_t eventActiveMask;
+
+/* ====================================================
+ * Prüfungen
+ * ==================================================== */
+static int checks = 0;
+static int failures = 0;
+
+#define CHECK(cond)                                                              \
+  do {                                                                           \
+    checks++;                                                                    \
+    if (!(cond)) {                                                               \
+      failures++;                                                                \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond);                 \
+    }                                                                            \
+  } while (0)
+
+#define CHECK_NEAR(a, b, tol)                                                    \
+  do {                                                                           \
+    checks++;                                                                    \
+    double a_ = (a), b_ = (b);                                                   \
+    if (!(std::fabs(a_ - b_) <= (tol))) {                                        \
+      failures++;                                                                \
+      fprintf(stderr, "%s:%d: %s = %g, erwartet %g (±%g)\n", __FILE__, __LINE__, \
+              #a, a_, b_, (double)(tol));                                        \
+    }                                                                            \
+  } while (0)
+
+// Firmware bis zum nächsten Messzyklus laufen lassen (virtuelle Zeit)
+static void runFor(uint64_t ms) {
+  uint64_t end = sim::nowMs() + ms;
+  while (sim::nowMs() < end) {
+    loop();
+    sim::sleepVirtual(10);
+  }
+}
+
+static WebServer::Response request(HTTPMethod method, const std::string& uri, const std::string& body = "") {
+  return server.execute(method, uri, {}, body);
+}
+
+// Zahl hinter "key": im Objekt "object":{...} (null => NAN)
+static double jsonNumber(const std::string& json, const std::string& object, const std::string& key) {
+  size_t from = json.find("\"" + object + "\":{");
+  if (from == std::string::npos) return NAN;
+  size_t at = json.find("\"" + key + "\":", from);
+  if (at == std::string::npos || at > json.find('}', from)) return NAN;
+  const char* p = json.c_str() + at + key.size() + 3;
+  return strncmp(p, "null", 4) == 0 ? NAN : strtod(p, nullptr);
+}
+
+// [mean,std,min,max] eines Fensters "w<len>" im Objekt "object"
+static std::vector<double> jsonWindow(const std::string& json, const std::string& object, int len) {
+  std::vector<double> out;
+  size_t from = json.find("\"" + object + "\":{");
+  if (from == std::string::npos) return out;
+  size_t at = json.find("\"w" + std::to_string(len) + "\":[", from);
+  if (at == std::string::npos || at > json.find('}', from)) return out;
+  const char* p = json.c_str() + json.find('[', at) + 1;
+  for (int i = 0; i < 4; i++) {
+    char* next;
+    if (strncmp(p, "null", 4) == 0) {
+      out.push_back(NAN);
+      next = (char*)p + 4;
+    } else {
+      out.push_back(strtod(p, &next));
+    }
+    p = next + 1;                       // Komma bzw. ]
+  }
+  return out;
+}
+
+/* ====================================================
+ * parseRange()
+ * ==================================================== */
+static void testParseRange() {
+  size_t start = 0, end = 0;
+  CHECK(parseRange("bytes=0-99", 1000, start, end) && start == 0 && end == 99);
+  CHECK(parseRange("bytes=900-", 1000, start, end) && start == 900 && end == 999);
+  CHECK(parseRange("bytes=-100", 1000, start, end) && start == 900 && end == 999);
+  CHECK(parseRange("bytes=-5000", 1000, start, end) && start == 0 && end == 999);
+  CHECK(parseRange("bytes=500-5000", 1000, start, end) && start == 500 && end == 999);
+  CHECK(parseRange("bytes=999-999", 1000, start, end) && start == 999 && end == 999);
+
+  CHECK(!parseRange("bytes=1000-", 1000, start, end));       // hinter dem Dateiende
+  CHECK(!parseRange("bytes=5-2", 1000, start, end));         // Ende vor Anfang
+  CHECK(!parseRange("bytes=abc-5", 1000, start, end));       // kein Zahlwert (nicht als 0 lesen)
+  CHECK(!parseRange("bytes=0-5x", 1000, start, end));
+  CHECK(!parseRange("bytes=0-1,5-6", 1000, start, end));     // mehrere Bereiche
+  CHECK(!parseRange("items=0-1", 1000, start, end));
+  CHECK(!parseRange("bytes=-0", 1000, start, end));
+  CHECK(!parseRange("bytes=-", 1000, start, end));
+  CHECK(!parseRange("bytes=5", 1000, start, end));
+  CHECK(!parseRange("bytes=0-0", 0, start, end));            // leere Datei
+}
+
+/* ====================================================
+ * DeflateStream
+ * ==================================================== */
+static void stringSink(void* ctx, const uint8_t* data, size_t len) {
+  ((std::string*)ctx)->append((const char*)data, len);
+}
+
+// Entpackt mit zlib; windowBits -15 = rohes Deflate, 31 = gzip. false bei Fehler.
+static bool inflateAll(const std::string& in, int windowBits, std::string& out) {
+  z_stream z = {};
+  if (inflateInit2(&z, windowBits) != Z_OK) return false;
+  z.next_in = (Bytef*)in.data();
+  z.avail_in = (uInt)in.size();
+  out.clear();
+  int ret;
+  do {
+    char buf[16384];
+    z.next_out = (Bytef*)buf;
+    z.avail_out = sizeof(buf);
+    ret = inflate(&z, Z_NO_FLUSH);
+    if (ret != Z_OK && ret != Z_STREAM_END) break;
+    out.append(buf, sizeof(buf) - z.avail_out);
+  } while (ret != Z_STREAM_END);
+  bool ok = ret == Z_STREAM_END && z.avail_in == 0;   // nichts hinter dem Ende
+  inflateEnd(&z);
+  return ok;
+}
+
+// Testdaten: leer, kurz, Logzeilen (typischer Export), Zufallsbytes, lange Wiederholung
+static std::vector<std::string> deflateSamples() {
+  std::vector<std::string> samples = {"", "Hallo"};
+
+  std::string csv = LOG_CSV_HEADER;
+  LogRow row = {};
+  row.timestamp = 1714644000;
+  char line[LOG_ROW_MAX];
+  for (int i = 0; i < 3000; i++) {
+    for (int c = 0; c < 4; c++) row.pressure[c] = 1.0f + c + 0.001f * ((i * 37 + c * 11) % 100);
+    row.flow[0] = 12.5f;
+    row.flow[1] = (i / 100) % 2 ? 6.25f : 0.0f;
+    row.cumulative[0] += row.flow[0] / 60.0;
+    row.cumulative[1] += row.flow[1] / 60.0;
+    csv.append(line, formatLogRow(row, line, sizeof(line)));
+    row.timestamp++;
+    row.runtime++;
+  }
+  samples.push_back(csv);
+
+  std::string random(50000, '\0');
+  uint32_t rng = 1;
+  for (char& c : random) {
+    rng = rng * 1664525u + 1013904223u;
+    c = (char)(rng >> 24);
+  }
+  samples.push_back(random);
+  samples.push_back(std::string(20000, 'a'));
+  return samples;
+}
+
+static void testDeflate() {
+  std::vector<std::string> samples = deflateSamples();
+  std::unique_ptr<DeflateEncoder> deflate(new DeflateEncoder());   // ~11 KB, nicht auf den Stack
+  std::unique_ptr<GzipWriter> gzip(new GzipWriter());
+
+  for (const std::string& data : samples) {
+    const uint8_t* bytes = (const uint8_t*)data.data();
+
+    // CRC-32 wie zlib, auch stückweise
+    uint32_t crc = crc32Update(0, bytes, data.size() / 3);
+    crc = crc32Update(crc, bytes + data.size() / 3, data.size() - data.size() / 3);
+    CHECK(crc == (uint32_t)crc32(0, bytes, (uInt)data.size()));
+
+    // Rohes Deflate, in ungleichen Stücken geschrieben
+    std::string packed, unpacked;
+    deflate->begin(stringSink, &packed);
+    for (size_t pos = 0, step = 1; pos < data.size(); pos += step, step = step * 3 % 5000 + 1) {
+      deflate->write(bytes + pos, std::min(step, data.size() - pos));
+    }
+    deflate->finish();
+    CHECK(deflate->bytesOut() == packed.size());
+    CHECK(inflateAll(packed, -15, unpacked) && unpacked == data);
+
+    // gzip-Rahmen: Kopf, Inhalt, CRC und Länge im Trailer
+    std::string gz;
+    gzip->begin(stringSink, &gz, 1714644000);
+    gzip->write(bytes, data.size());
+    gzip->finish();
+    CHECK(gz.size() >= 18 && (uint8_t)gz[0] == 0x1f && (uint8_t)gz[1] == 0x8b && gz[2] == 8);
+    CHECK(inflateAll(gz, 31, unpacked) && unpacked == data);
+  }
+  // Logzeilen müssen auch mit festen Huffman-Codes deutlich kleiner werden
+  std::string packed;
+  deflate->begin(stringSink, &packed);
+  deflate->write((const uint8_t*)samples[2].data(), samples[2].size());
+  deflate->finish();
+  CHECK(packed.size() < samples[2].size() / 2);
+}
+
+static uint32_t le16(const std::string& s, size_t at) {
+  return (uint8_t)s[at] | (uint8_t)s[at + 1] << 8;
+}
+
+static uint32_t le32(const std::string& s, size_t at) {
+  return le16(s, at) | le16(s, at + 2) << 16;
+}
+
+// Liest das Zentralverzeichnis und entpackt jeden Eintrag über seinen lokalen Kopf
+static bool readZip(const std::string& zip, std::vector<std::pair<std::string, std::string>>& entries) {
+  entries.clear();
+  if (zip.size() < 22) return false;
+  size_t eocd = zip.size() - 22;
+  if (le32(zip, eocd) != 0x06054b50) return false;
+  uint32_t count = le16(zip, eocd + 10);
+  size_t at = le32(zip, eocd + 16);
+  if (le32(zip, eocd + 12) + at != eocd) return false;   // Größe + Offset des Verzeichnisses
+  for (uint32_t i = 0; i < count; i++) {
+    if (at + 46 > zip.size() || le32(zip, at) != 0x02014b50) return false;
+    uint32_t method = le16(zip, at + 10), crc = le32(zip, at + 16);
+    uint32_t compSize = le32(zip, at + 20), size = le32(zip, at + 24);
+    uint32_t nameLen = le16(zip, at + 28), extraLen = le16(zip, at + 30), commentLen = le16(zip, at + 32);
+    uint32_t local = le32(zip, at + 42);
+    std::string name = zip.substr(at + 46, nameLen);
+    at += 46 + nameLen + extraLen + commentLen;
+
+    if (local + 30 > zip.size() || le32(zip, local) != 0x04034b50) return false;
+    if (zip.compare(local + 30, nameLen, name) != 0) return false;
+    size_t dataStart = local + 30 + le16(zip, local + 26) + le16(zip, local + 28);
+    std::string data = zip.substr(dataStart, compSize), content;
+    if (method == 0) content = data;
+    else if (method != 8 || !inflateAll(data, -15, content)) return false;
+    if (content.size() != size || (uint32_t)crc32(0, (const Bytef*)content.data(), (uInt)content.size()) != crc) return false;
+    entries.emplace_back(name, content);
+  }
+  return true;
+}
+
+static void testZip() {
+  std::vector<std::string> samples = deflateSamples();
+  for (bool useDeflate : {true, false}) {
+    std::string zip;
+    std::unique_ptr<ZipWriter> writer(new ZipWriter());
+    CHECK(writer->begin(stringSink, &zip, 3, useDeflate));
+    const char* names[] = {"2024-05-02_Rohdaten.csv", "leer.csv", "zufall.bin"};
+    const std::string* contents[] = {&samples[2], &samples[0], &samples[3]};
+    for (int i = 0; i < 3; i++) {
+      CHECK(writer->beginEntry(names[i], 1714644000));
+      writer->write((const uint8_t*)contents[i]->data(), contents[i]->size());
+      writer->endEntry();
+    }
+    CHECK(!writer->beginEntry("zu_viel.csv", 1714644000));   // maxEntries erreicht
+    writer->finish();
+
+    std::vector<std::pair<std::string, std::string>> entries;
+    CHECK(readZip(zip, entries));
+    CHECK(entries.size() == 3);
+    for (size_t i = 0; i < entries.size() && i < 3; i++) {
+      CHECK(entries[i].first == names[i]);
+      CHECK(entries[i].second == *contents[i]);
+    }
+  }
+}
+
+/* ====================================================
+ * Totalisator
+ * ==================================================== */
+static void testTotalizer() {
+  clearTotalizer();
+  loadTotalizer();
+  CHECK(totalPulses1 == 0 && totalPulses2 == 0);
+
+  // Mehr als zwei Umläufe des Journals (Basisstand alle TOTALIZER_SLOTS Commits)
+  for (int i = 1; i <= 3 * TOTALIZER_SLOTS + 3; i++) {
+    totalPulses1 += 1000 + i;
+    totalPulses2 += i % 4 ? i : 0;
+    commitTotalizer();
+  }
+  uint32_t seq = totalizerSeq;
+  commitTotalizer();                    // ohne Zuwachs: kein Eintrag
+  CHECK(totalizerSeq == seq);
+
+  uint64_t expected[2] = {totalPulses1, totalPulses2};
+  totalPulses1 = totalPulses2 = 0;
+  committedPulses[0] = committedPulses[1] = 0;
+  loadTotalizer();
+  CHECK(totalPulses1 == expected[0] && totalPulses2 == expected[1]);
+  CHECK(totalizerSeq == seq);
+
+  // Zurücksetzen: die alten Journal-Einträge dürfen nicht mehr zählen
+  clearTotalizer();
+  loadTotalizer();
+  CHECK(totalPulses1 == 0 && totalPulses2 == 0);
+  for (int i = 1; i <= 3; i++) {
+    totalPulses1 += 10;
+    commitTotalizer();
+  }
+  loadTotalizer();
+  CHECK(totalPulses1 == 30 && totalPulses2 == 0);
+}
+
+/* ====================================================
+ * Warmstart: Block-CRCs
+ * ==================================================== */
+static void testRetainedBlocks() {
+  runFor(65000);                        // gut drei Blöcke im 10-Minuten-Puffer
+  std::vector<SensorData> before(dataBuffer, dataBuffer + BUFFER_SIZE);
+  int index = bufferIndex;
+  CHECK(index >= 3 * RETAINED_BLOCK);
+
+  // Unbeschädigt übernommen
+  sim::setResetReason(ESP_RST_PANIC);
+  restoreRetainedState();
+  CHECK(warmRestart);
+  CHECK(bufferIndex == index);
+  CHECK(memcmp(before.data(), dataBuffer, sizeof(SensorData) * BUFFER_SIZE) == 0);
+
+  // Ein geänderter Wert verwirft genau seinen Block
+  dataBuffer[RETAINED_BLOCK + 5].pressure[1] += 1.0f;
+  restoreRetainedState();
+  CHECK(warmRestart);
+  bool blockCleared = true;
+  for (int i = RETAINED_BLOCK; i < 2 * RETAINED_BLOCK; i++) blockCleared = blockCleared && dataBuffer[i].timestamp == 0;
+  CHECK(blockCleared);
+  CHECK(memcmp(&before[0], &dataBuffer[0], sizeof(SensorData) * RETAINED_BLOCK) == 0);
+  CHECK(memcmp(&before[2 * RETAINED_BLOCK], &dataBuffer[2 * RETAINED_BLOCK], sizeof(SensorData) * RETAINED_BLOCK) == 0);
+
+  // Nach dem Einschalten nichts übernehmen
+  sim::setResetReason(ESP_RST_POWERON);
+  restoreRetainedState();
+  CHECK(!warmRestart);
+  CHECK(bufferIndex == 0 && dataBuffer[0].timestamp == 0);
+  rebuildWindowStats();                 // wie setup() nach dem Kaltstart
+}
+
+/* ====================================================
+ * Kennwerte
+ * ==================================================== */
+struct Expected {
+  double mean, std, min, max;
+};
+
+static Expected exact(const std::vector<double>& v) {
+  Expected e = {0, 0, v[0], v[0]};
+  for (double x : v) {
+    e.mean += x;
+    e.min = std::min(e.min, x);
+    e.max = std::max(e.max, x);
+  }
+  e.mean /= v.size();
+  for (double x : v) e.std += (x - e.mean) * (x - e.mean);
+  e.std = std::sqrt(e.std / (v.size() - 1));
+  return e;
+}
+
+static void checkWindow(const std::string& json, const std::vector<double>& values, int len) {
+  std::vector<double> w = jsonWindow(json, "p1", len);
+  CHECK(w.size() == 4);
+  if (w.size() != 4) return;
+  Expected e = exact(std::vector<double>(values.end() - len, values.end()));
+  CHECK_NEAR(w[0], e.mean, 1e-3);
+  CHECK_NEAR(w[1], e.std, 1e-3);
+  CHECK_NEAR(w[2], e.min, 1e-3);
+  CHECK_NEAR(w[3], e.max, 1e-3);
+}
+
+// Schreibt einen Messwert wie loop() in dataBuffer und schreibt die Kennwerte fort
+static void addSample(std::vector<double>& values, uint32_t& rng) {
+  rng = rng * 1664525u + 1013904223u;
+  float x = (rng >> 8) * (10.0f / 16777216.0f);   // gleichverteilt 0..10
+  SensorData& d = dataBuffer[bufferIndex];
+  d.timestamp = 1714644000 + values.size();
+  d.pressure[0] = x;
+  d.pressure[1] = d.pressure[2] = d.pressure[3] = 1.0f;
+  d.flowRate1 = d.flowRate2 = 5.0f;
+  updateStats(bufferIndex);
+  bufferIndex = (bufferIndex + 1) % BUFFER_SIZE;
+  values.push_back(x);
+}
+
+static void testStats() {
+  CHECK(request(HTTP_POST, "/api/stats", "{\"w0\":60,\"w1\":300}").code == 200);
+  resetSessionStats();
+  std::vector<double> values;
+  uint32_t rng = 7;
+  for (int i = 0; i < 2000; i++) addSample(values, rng);   // mehr als ein Umlauf von dataBuffer
+
+  stateVersion++;                       // Antwort-Cache verwerfen
+  std::string json = request(HTTP_GET, "/api/stats").body;
+  Expected e = exact(values);
+  CHECK_NEAR(jsonNumber(json, "p1", "n"), values.size(), 0);
+  CHECK_NEAR(jsonNumber(json, "p1", "mean"), e.mean, 1e-3);
+  CHECK_NEAR(jsonNumber(json, "p1", "std"), e.std, 1e-3);
+  CHECK_NEAR(jsonNumber(json, "p1", "min"), e.min, 1e-3);
+  CHECK_NEAR(jsonNumber(json, "p1", "max"), e.max, 1e-3);
+
+  // P²: Schätzung, bei 2000 gleichverteilten Werten auf wenige Prozent genau
+  std::vector<double> sorted = values;
+  std::sort(sorted.begin(), sorted.end());
+  CHECK_NEAR(jsonNumber(json, "p1", "p50"), sorted[sorted.size() * 50 / 100], 0.3);
+  CHECK_NEAR(jsonNumber(json, "p1", "p90"), sorted[sorted.size() * 90 / 100], 0.3);
+  CHECK_NEAR(jsonNumber(json, "p1", "p99"), sorted[sorted.size() * 99 / 100], 0.3);
+
+  // Gleitende Fenster (Welford mit Herausrechnen, Min/Max über Deques)
+  checkWindow(json, values, 60);
+  checkWindow(json, values, 300);
+  CHECK_NEAR(jsonNumber(json, "dp12", "mean"), e.mean - 1.0, 1e-3);
+
+  // Neue Fensterlängen: Neuaufbau aus dataBuffer, danach wieder fortschreiben
+  CHECK(request(HTTP_POST, "/api/stats", "{\"w0\":30,\"w1\":120}").code == 200);
+  json = request(HTTP_GET, "/api/stats").body;
+  checkWindow(json, values, 30);
+  checkWindow(json, values, 120);
+  for (int i = 0; i < 50; i++) addSample(values, rng);
+  stateVersion++;
+  json = request(HTTP_GET, "/api/stats").body;
+  checkWindow(json, values, 30);
+  checkWindow(json, values, 120);
+  CHECK(request(HTTP_POST, "/api/stats", "{\"w0\":120,\"w1\":30}").code == 400);
+  CHECK(request(HTTP_POST, "/api/stats", "{\"w1\":301}").code == 400);
+  CHECK(request(HTTP_POST, "/api/stats", "{\"w0\":60,\"w1\":300}").code == 200);
+}
+
+/* ====================================================
+ * Ereigniserkennung
+ * ==================================================== */
+static void evaluate(float pressure1) {
+  float channels[6] = {pressure1, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f};
+  evaluateEvents(channels, micros());
+}
+
+static void testEventHysteresis() {
+  CHECK(request(HTTP_POST, "/api/rules", "{\"index\":0,\"enabled\":true,\"type\":\"above\",\"a\":0,"
+                                         "\"threshold\":2,\"hysteresis\":0.5,\"hold\":2,\"name\":\"Test\"}").code == 200);
+  uint32_t base = eventLastId;
+  auto active = []() { return (eventActiveMask & 1) != 0; };
+
+  evaluate(1.0f);
+  evaluate(2.5f);                       // erst ein Zyklus über der Schwelle
+  evaluate(1.0f);
+  CHECK(eventLastId == base && !active());
+  evaluate(2.5f);
+  evaluate(2.5f);                       // zwei in Folge: ausgelöst
+  CHECK(eventLastId == base + 1 && active());
+
+  evaluate(1.8f);                       // unter der Schwelle, aber innerhalb der Hysterese
+  evaluate(1.8f);
+  CHECK(eventLastId == base + 1 && active());
+  evaluate(1.4f);
+  evaluate(1.6f);                       // unterbrochen: Zähler beginnt neu
+  CHECK(eventLastId == base + 1 && active());
+  evaluate(1.4f);
+  evaluate(1.4f);                       // zwei in Folge unter Schwelle - Hysterese: beendet
+  CHECK(eventLastId == base + 2 && !active());
+
+  // Fehlende Werte (ADS1115 weg) lösen weder aus noch heben sie auf
+  evaluate(2.5f);
+  evaluate(2.5f);
+  CHECK(eventLastId == base + 3 && active());
+  for (int i = 0; i < 5; i++) evaluate(NAN);
+  CHECK(eventLastId == base + 3 && active());
+  evaluate(1.0f);
+  evaluate(1.0f);
+  CHECK(eventLastId == base + 4 && !active());
+
+  // Lesen verändert nichts (deliveryMs setzt nur der Push an einen Stream)
+  std::string uri = "/api/events?since=" + std::to_string(base);
+  std::string first = request(HTTP_GET, uri).body;
+  CHECK(first.find("\"id\":" + std::to_string(base + 4)) != std::string::npos);
+  CHECK(first.find("\"deliveryMs\":0") != std::string::npos);
+  CHECK(request(HTTP_GET, uri).body == first);
+
+  CHECK(request(HTTP_POST, "/api/rules", "{\"index\":0,\"enabled\":false}").code == 200);
+}
+
+/* ====================================================
+ * Start
+ * ==================================================== */
+int main() {
+  std::string fsDir = "/tmp/hosttest_" + std::to_string(getpid());
+  SPIFFS.setRoot(fsDir);
+  SPIFFS.format();
+  mkdir(fsDir.c_str(), 0755);
+  Serial.quiet = true;
+  sim::setSpeed(1000);
+
+  setup();
+  request(HTTP_GET, "/setTime?t=1714644000");
+
+  testParseRange();
+  testDeflate();
+  testZip();
+  testRetainedBlocks();
+  testTotalizer();
+  testStats();
+  testEventHysteresis();
+
+  printf("%d Prüfungen, %d fehlgeschlagen\n", checks, failures);
+  fflush(stdout);
+  SPIFFS.format();
+  rmdir(fsDir.c_str());
+  // Firmware-Tasks laufen endlos; ohne Destruktoren beenden
+  _exit(failures ? 1 : 0);
+}
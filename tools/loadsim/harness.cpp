@@ -0,0 +1,681 @@
+/*****************************************************
+ * harness.cpp – Lastsimulation der Firmware auf dem PC
+ *
+ * Übersetzt src/main.cpp unverändert gegen die Ersatz-Header in
+ * tools/loadsim/include und betreibt die komplette Kette:
+ *   Messwertquelle -> ADC/Impulse -> loop() (Ringpuffer, logData(),
+ *   Totalisator, Warmstart-Zustand, Uplink) -> Web-Handler -> Clients
+ *
+ * Messwertquelle:
+ *   --replay DATEI.csv   aufgezeichnete Logdatei (*_Rohdaten.csv), Zeile für Zeile
+ *   sonst                synthetisch: Druckrampen und Impulsfolgen (an/aus)
+ *
+ * Clients (je ein Thread, Abfrageintervalle in virtueller Zeit wie im Browser):
+ *   dashboard  index.html: /api/sensorwerte und /api/loggingData jede Sekunde,
+ *              Ereignisse über eine offene SSE-Verbindung (/api/events/stream)
+ *   charts     charts.html: /api/last10min jede Sekunde, /api/stats alle 5 s
+ *   logcharts  logcharts.html: /api/logdata jede Minute
+ *   calibrate  calibrate.html: /api/calibration, /updateCalibration, /api/uplink
+ *   download   /downloadlog (ganz, gzip, Range), /downloadzip
+ *   monitor    Überwachung von außen: /api/health alle 10 s, /api/events alle 5 s
+ * Löschen, Zurücksetzen und /calibrateVmin werden nicht aufgerufen, weil sie
+ * den Messlauf verändern würden.
+ *
+ * Bericht: Durchsatz, Latenz-Perzentile je Route, Heap-Spitze der Firmware,
+ * in den Flash geschriebene Bytes und verpasste Messzyklen.
+ *
+ * Bauen:
+ *   pio run -e loadsim                      (Programm: .pio/build/loadsim/program)
+ *   oder direkt:
+ *   g++ -O2 -std=gnu++17 -pthread -Itools/loadsim/include -Ilib/LogFormat -Ilib/DeflateStream \
+ *       src/main.cpp tools/loadsim/harness.cpp tools/loadsim/sim_core.cpp tools/loadsim/sim_net.cpp \
+ *       tools/loadsim/sim_storage.cpp lib/LogFormat/LogFormat.cpp lib/DeflateStream/DeflateStream.cpp \
+ *       -o loadsim
+ *
+ * Beispiele:
+ *   loadsim --speed 1000 --duration 7200
+ *   loadsim --replay 2024-05-02_Rohdaten.csv --clients dashboard=4,charts=2 --heap-kb 120
+ *   loadsim --hammer --duration 600
+ *   loadsim --uplink http://127.0.0.1:8080/ingest    (mit tools/mock_collector.py)
+ *   loadsim --rule '{"index":0,"enabled":true,"type":"drop","a":0,"threshold":0.05,"window":3}'
+ *   loadsim --adc-after 20         (ADS1115 meldet sich erst nach 20 s: Betrieb ohne Druckwerte)
+ *   loadsim --adc-lost 120         (ADS1115 fällt nach 120 s für 30 s aus)
+ *****************************************************/
+#include "sim.h"
+
+#include <Arduino.h>
+#include <Adafruit_ADS1X15.h>
+#include <EEPROM.h>
+#include <Preferences.h>
+#include <SPIFFS.h>
+#include <WebServer.h>
+#include <Wire.h>
+#include <LogFormat.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ====================================================
+ * Firmware (src/main.cpp)
+ * ==================================================== */
+void setup();
+void loop();
+void flowSensor1ISR();
+void flowSensor2ISR();
+extern WebServer server;
+extern float pressureSensor_V_min[4];
+extern float pressureSensor_V_max[4];
+extern float pressureSensor_PSI_min[4];
+extern float pressureSensor_PSI_max[4];
+extern uint32_t sampleSeq;
+extern uint32_t logRowCount;
+extern String logFileName;
+extern bool recording;
+extern volatile uint32_t uplinkSent;
+extern volatile uint32_t uplinkDropped;
+extern uint32_t eventLastId;
+extern uint32_t eventLatencyUsMax;
+extern uint32_t eventEvalUsMax;
+extern uint32_t eventDeliveryMsMax;
+extern unsigned long previousMillis;
+extern Adafruit_ADS1115 ads;
+
+#define ADS_VOLTAGE_PER_BIT 0.000125    // wie in src/main.cpp
+#define PULSES_PER_LPM      11.0        // Impulse pro Sekunde je L/min (flowRate = delta / 11.0)
+#define TICK_MS             1000UL      // interval in src/main.cpp (dort const, also nicht extern erreichbar)
+#define ADC_LOST_MS         30000UL     // Dauer des Ausfalls bei --adc-lost
+
+/* ====================================================
+ * Messwertquellen
+ * ==================================================== */
+struct Sample {
+  float pressure[4];   // bar
+  float flow[2];       // L/min
+};
+
+class SampleSource {
+public:
+  virtual ~SampleSource() {}
+  virtual Sample at(uint64_t second) = 0;
+  virtual time_t startTime() = 0;
+  virtual std::string describe() = 0;
+};
+
+// Synthetisch: Sägezahn-Rampen mit leichtem Rauschen, Durchfluss als Impulsfolge (an/aus)
+class SyntheticSource : public SampleSource {
+public:
+  Sample at(uint64_t s) override {
+    Sample v;
+    for (int i = 0; i < 4; i++) {
+      uint64_t period = 300 + 60 * i;
+      float ramp = (float)(s % period) / period;
+      v.pressure[i] = 0.05f + 0.5f * ramp + noise(s * 4 + i) * 0.005f;   // im Messbereich der Standard-Kalibrierung (0-10 PSI)
+    }
+    v.flow[0] = (s % 180) < 120 ? 12.0f : 0.0f;            // 2 min an, 1 min aus
+    v.flow[1] = (s % 600) < 30 ? 25.0f : 6.0f;             // Grundlast mit Spitzen
+    return v;
+  }
+  time_t startTime() override { return 1714644000; }       // 2024-05-02 12:00 Uhr MESZ
+  std::string describe() override { return "synthetisch (Druckrampen, Impulsfolgen)"; }
+
+private:
+  static float noise(uint64_t n) {
+    uint32_t x = (uint32_t)(n * 2654435761u);
+    x ^= x >> 13;
+    x *= 0x5bd1e995;
+    x ^= x >> 15;
+    return (x & 0xFFFF) / 32768.0f - 1.0f;
+  }
+};
+
+// Wiedergabe einer Logdatei; nach der letzten Zeile geht es von vorn los
+class ReplaySource : public SampleSource {
+public:
+  bool load(const std::string& path, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+      error = "kann nicht geöffnet werden";
+      return false;
+    }
+    std::string line;
+    LogTimeCache cache;
+    LogRow row;
+    while (std::getline(in, line)) {
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      if (!parseLogRow(line.data(), line.size(), row, &cache)) continue;
+      if (_rows.empty()) _start = row.timestamp;
+      Sample v;
+      for (int i = 0; i < 4; i++) v.pressure[i] = row.pressure[i];
+      v.flow[0] = row.flow[0];
+      v.flow[1] = row.flow[1];
+      _rows.push_back(v);
+    }
+    _path = path;
+    if (_rows.empty()) error = "keine Messzeilen";
+    return !_rows.empty();
+  }
+  Sample at(uint64_t s) override { return _rows[s % _rows.size()]; }
+  time_t startTime() override { return _start; }
+  std::string describe() override { return _path + " (" + std::to_string(_rows.size()) + " Zeilen)"; }
+
+private:
+  std::vector<Sample> _rows;
+  time_t _start = 0;
+  std::string _path;
+};
+
+static Sample currentSample = {};
+
+// Druck (bar) -> Rohwert des ADS1115, Umkehrung von readPressureSensor() mit der aktuellen Kalibrierung
+static int16_t rawForPressure(uint8_t ch) {
+  if (ch >= 4) return 0;
+  float vMin = pressureSensor_V_min[ch], vMax = pressureSensor_V_max[ch];
+  float psiMin = pressureSensor_PSI_min[ch], psiMax = pressureSensor_PSI_max[ch];
+  float conv = vMax != vMin ? (psiMax - psiMin) / (vMax - vMin) : 0;
+  float voltage = conv != 0 ? vMin + (currentSample.pressure[ch] * 14.5038f - psiMin) / conv : vMin;
+  long raw = lround(voltage / ADS_VOLTAGE_PER_BIT);
+  return (int16_t)constrain(raw, -32768L, 32767L);
+}
+
+/* ====================================================
+ * Optionen
+ * ==================================================== */
+struct Options {
+  double speed = 100;
+  uint64_t duration = 3600;             // virtuelle Sekunden
+  std::string replay;
+  std::string clients = "dashboard=2,charts=1,logcharts=1,calibrate=1,download=1,monitor=1";
+  bool hammer = false;
+  bool record = true;
+  uint64_t heapKb = 160;
+  uint64_t fsKb = 1342;
+  std::string dataDir = "data";
+  std::string fsDir;
+  std::string uplink;
+  std::vector<std::string> rules;       // JSON für POST /api/rules
+  uint64_t adcAfter = 0;                // virtuelle Sekunden, bis der ADS1115 antwortet
+  uint64_t adcLost = 0;                 // virtuelle Sekunde, ab der der ADS1115 für ADC_LOST_MS fehlt (0 = nie)
+  bool verbose = false;
+};
+
+static void usage() {
+  fprintf(stderr,
+          "Aufruf: loadsim [Optionen]\n"
+          "  --speed N        virtuelle Zeit läuft N-mal schneller (Standard 100, bis 1000 sinnvoll)\n"
+          "  --duration S     simulierte Dauer in Sekunden (Standard 3600)\n"
+          "  --replay DATEI   Messwerte aus einer Logdatei (*_Rohdaten.csv) statt synthetisch\n"
+          "  --clients LISTE  Clients je Profil, z. B. dashboard=3,charts=2,logcharts=1,calibrate=1,download=1,monitor=1\n"
+          "  --hammer         Clients fragen ohne Pause ab (statt im Takt der Webseiten)\n"
+          "  --no-record      keine Aufnahme starten\n"
+          "  --heap-kb N      freier Heap des ESP32 nach dem Start (Standard 160)\n"
+          "  --fs-kb N        Größe des SPIFFS (Standard 1342)\n"
+          "  --data DIR       Webseitendateien, die vorab ins SPIFFS kommen (Standard data)\n"
+          "  --fs DIR         Verzeichnis für das simulierte SPIFFS (Standard: temporär)\n"
+          "  --uplink URL     Telemetrie-Uplink aktivieren (z. B. gegen tools/mock_collector.py)\n"
+          "  --rule JSON      Regel der Ereigniserkennung setzen (mehrfach möglich), z. B.\n"
+          "                   '{\"index\":0,\"enabled\":true,\"type\":\"above\",\"a\":0,\"threshold\":1.5,\"hysteresis\":0.2}'\n"
+          "  --adc-after S    ADS1115 antwortet erst nach S Sekunden (Start ohne ADC, Wiederholversuche)\n"
+          "  --adc-lost S     ADS1115 fällt nach S Sekunden für 30 s aus (Ausfall im Betrieb)\n"
+          "  --verbose        Serial-Ausgaben der Firmware anzeigen\n");
+}
+
+static bool parseOptions(int argc, char** argv, Options& opt) {
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (a == "--speed" && hasValue)          opt.speed = atof(argv[++i]);
+    else if (a == "--duration" && hasValue)  opt.duration = strtoull(argv[++i], nullptr, 10);
+    else if (a == "--replay" && hasValue)    opt.replay = argv[++i];
+    else if (a == "--clients" && hasValue)   opt.clients = argv[++i];
+    else if (a == "--hammer")                opt.hammer = true;
+    else if (a == "--no-record")             opt.record = false;
+    else if (a == "--heap-kb" && hasValue)   opt.heapKb = strtoull(argv[++i], nullptr, 10);
+    else if (a == "--fs-kb" && hasValue)     opt.fsKb = strtoull(argv[++i], nullptr, 10);
+    else if (a == "--data" && hasValue)      opt.dataDir = argv[++i];
+    else if (a == "--fs" && hasValue)        opt.fsDir = argv[++i];
+    else if (a == "--uplink" && hasValue)    opt.uplink = argv[++i];
+    else if (a == "--rule" && hasValue)      opt.rules.push_back(argv[++i]);
+    else if (a == "--adc-after" && hasValue) opt.adcAfter = strtoull(argv[++i], nullptr, 10);
+    else if (a == "--adc-lost" && hasValue)  opt.adcLost = strtoull(argv[++i], nullptr, 10);
+    else if (a == "--verbose")               opt.verbose = true;
+    else return false;
+  }
+  return opt.speed > 0 && opt.duration > 0;
+}
+
+/* ====================================================
+ * Clients
+ * ==================================================== */
+struct RouteStats {
+  std::vector<uint32_t> latencyUs;   // Antwortzeit aus Sicht des Clients (Warten + Bearbeitung)
+  std::vector<uint32_t> serviceUs;   // Bearbeitungszeit im Handler
+  uint64_t bytes = 0;
+  uint64_t ok = 0, notModified = 0, clientErrors = 0, serverErrors = 0;
+
+  void merge(const RouteStats& o) {
+    latencyUs.insert(latencyUs.end(), o.latencyUs.begin(), o.latencyUs.end());
+    serviceUs.insert(serviceUs.end(), o.serviceUs.begin(), o.serviceUs.end());
+    bytes += o.bytes;
+    ok += o.ok;
+    notModified += o.notModified;
+    clientErrors += o.clientErrors;
+    serverErrors += o.serverErrors;
+  }
+};
+
+struct Request {
+  std::string route;                 // Name im Bericht
+  HTTPMethod method;
+  std::string uri;
+  std::map<std::string, std::string> headers;
+  std::string body;
+};
+
+// Eine regelmäßige Abfrage einer Seite
+struct Poll {
+  uint64_t periodMs;                 // virtuelle Zeit
+  std::function<Request(uint64_t n)> make;
+  uint64_t due = 0;
+  uint64_t count = 0;
+};
+
+struct Profile {
+  std::vector<Request> onLoad;       // beim Öffnen der Seite
+  std::vector<Poll> polls;
+};
+
+static std::atomic<bool> clientsRunning{true};
+static std::atomic<size_t> clientsFinished{0};
+static std::string currentLog;       // Logdatei der Aufnahme (vor dem Start der Clients gesetzt)
+static float calibration[4][4];      // v_min, v_max, psi_min, psi_max je Sensor (für /updateCalibration)
+
+static Request get(const std::string& route, const std::string& uri) {
+  return {route, HTTP_GET, uri, {}, ""};
+}
+
+static bool makeProfile(const std::string& name, Profile& p) {
+  if (name == "dashboard") {
+    p.onLoad = {get("/", "/"), get("/style.css", "/style.css"), get("/script.js", "/script.js"),
+                get("/chart.umd.min.js", "/chart.umd.min.js"), get("/getTime", "/getTime"),
+                get("/api/events/stream", "/api/events/stream?since=0")};
+    p.polls.push_back({1000, [](uint64_t) { return get("/api/sensorwerte", "/api/sensorwerte"); }});
+    p.polls.push_back({1000, [](uint64_t) { return get("/api/loggingData", "/api/loggingData"); }});
+  } else if (name == "charts") {
+    p.onLoad = {get("/charts.html", "/charts.html"), get("/charts.js", "/charts.js"),
+                get("/chart.umd.min.js", "/chart.umd.min.js"), get("/adapter-datefns.min.js", "/adapter-datefns.min.js")};
+    p.polls.push_back({1000, [](uint64_t) { return get("/api/last10min", "/api/last10min"); }});
+    p.polls.push_back({5000, [](uint64_t) { return get("/api/stats", "/api/stats"); }});
+  } else if (name == "logcharts") {
+    p.onLoad = {get("/logcharts.html", "/logcharts.html"), get("/logcharts.js", "/logcharts.js")};
+    p.polls.push_back({60000, [](uint64_t) { return get("/api/logdata", "/api/logdata?name=" + currentLog + "&max=3000"); }});
+  } else if (name == "calibrate") {
+    p.onLoad = {get("/calibrate.html", "/calibrate.html"), get("/calibrate.js", "/calibrate.js")};
+    p.polls.push_back({30000, [](uint64_t) { return get("/api/calibration", "/api/calibration"); }});
+    p.polls.push_back({30000, [](uint64_t) { return get("/api/uplink", "/api/uplink"); }});
+    p.polls.push_back({300000, [](uint64_t n) {
+      // Unveränderte Werte zurückschreiben: belastet EEPROM/Warmstart-Zustand, ändert die Messung nicht
+      int s = (int)(n % 4);
+      char body[160];
+      snprintf(body, sizeof(body), "{\"sensor\":%d,\"v_min\":%.4f,\"v_max\":%.4f,\"psi_min\":%.4f,\"psi_max\":%.4f}",
+               s, calibration[s][0], calibration[s][1], calibration[s][2], calibration[s][3]);
+      return Request{"/updateCalibration", HTTP_POST, "/updateCalibration", {}, body};
+    }});
+  } else if (name == "download") {
+    p.polls.push_back({60000, [](uint64_t) {
+      Request r = get("/downloadlog (Range)", "/downloadlog?name=" + currentLog);
+      r.headers["Range"] = "bytes=-4096";
+      return r;
+    }});
+    p.polls.push_back({600000, [](uint64_t) { return get("/downloadlog", "/downloadlog?name=" + currentLog); }});
+    p.polls.push_back({600000, [](uint64_t) {
+      Request r = get("/downloadlog (gzip)", "/downloadlog?gzip=1&name=" + currentLog);
+      r.headers["Accept-Encoding"] = "gzip";
+      return r;
+    }});
+    p.polls.push_back({1800000, [](uint64_t) { return get("/downloadzip", "/downloadzip"); }});
+  } else if (name == "monitor") {
+    p.polls.push_back({10000, [](uint64_t) { return get("/api/health", "/api/health"); }});
+    p.polls.push_back({5000, [](uint64_t) { return get("/api/events", "/api/events?since=0"); }});
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static void record(RouteStats& s, const WebServer::Response& r, uint64_t latencyUs) {
+  s.latencyUs.push_back((uint32_t)std::min<uint64_t>(latencyUs, UINT32_MAX));
+  s.serviceUs.push_back((uint32_t)std::min<uint64_t>(r.serviceUs, UINT32_MAX));
+  s.bytes += r.body.size();
+  if (r.code == 304)                     s.notModified++;
+  else if (r.code >= 200 && r.code < 300) s.ok++;
+  else if (r.code >= 400 && r.code < 500) s.clientErrors++;
+  else if (r.code == 503 && !r.header("Retry-After").empty()) s.clientErrors++;   // gewollte Abweisung (z. B. alle Streams belegt)
+  else                                    s.serverErrors++;   // 5xx oder keine Antwort
+}
+
+static void clientLoop(Profile& profile, bool hammer, std::map<std::string, RouteStats>* stats) {
+  std::map<std::string, std::string> etags;    // wie der Browser-Cache: If-None-Match für bekannte ETags
+  std::vector<std::pair<std::string, std::shared_ptr<WiFiPipe>>> streams;   // offene Verbindungen (SSE)
+
+  auto perform = [&](Request req) {
+    auto et = etags.find(req.uri);
+    if (et != etags.end()) req.headers["If-None-Match"] = et->second;
+    uint64_t start = sim::wallUs();
+    WebServer::Response r = server.request(req.method, req.uri, req.headers, req.body);
+    record((*stats)[req.route], r, sim::wallUs() - start);
+    std::string etag = r.header("ETag");
+    if (!etag.empty()) etags[req.uri] = etag;
+    if (r.pipe) streams.emplace_back(req.route, r.pipe);
+  };
+  // Beim Schließen der Seite: Verbindungen trennen, empfangene Bytes zählen
+  auto closeStreams = [&]() {
+    for (auto& st : streams) {
+      st.second->open = false;
+      (*stats)[st.first].bytes += st.second->take().size();
+    }
+  };
+
+  for (auto& req : profile.onLoad) {
+    if (!clientsRunning) return closeStreams();
+    perform(req);
+  }
+  uint64_t now = sim::nowMs();
+  for (auto& p : profile.polls) p.due = now;
+  while (clientsRunning && !profile.polls.empty()) {
+    Poll* next = &profile.polls[0];
+    for (auto& p : profile.polls) {
+      if (p.due < next->due) next = &p;
+    }
+    now = sim::nowMs();
+    if (!hammer && next->due > now) {
+      sim::sleepVirtual(std::min<uint64_t>(next->due - now, 100));   // regelmäßig auf Ende prüfen
+      continue;
+    }
+    perform(next->make(next->count++));
+    next->due = hammer ? sim::nowMs() : next->due + next->periodMs;
+    if (!hammer && next->due < now) next->due = now;     // Rückstand nicht nachholen (wie setInterval)
+  }
+  closeStreams();
+}
+
+static void clientThread(Profile profile, bool hammer, std::map<std::string, RouteStats>* stats) {
+  clientLoop(profile, hammer, stats);
+  clientsFinished++;
+}
+
+/* ====================================================
+ * Bericht
+ * ==================================================== */
+static double percentileMs(std::vector<uint32_t>& v, double p) {
+  if (v.empty()) return 0;
+  size_t k = (size_t)(p / 100.0 * (v.size() - 1) + 0.5);
+  std::nth_element(v.begin(), v.begin() + k, v.end());
+  return v[k] / 1000.0;
+}
+
+static std::string kb(uint64_t bytes) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.1f KB", bytes / 1024.0);
+  return buf;
+}
+
+// Webseitendateien ins simulierte SPIFFS kopieren (wie "Upload Filesystem Image", zählt nicht als Schreiblast)
+static void copyDataDir(const std::string& from, const std::string& to) {
+  DIR* d = opendir(from.c_str());
+  if (!d) {
+    fprintf(stderr, "Hinweis: Verzeichnis %s nicht gefunden, statische Seiten fehlen\n", from.c_str());
+    return;
+  }
+  while (struct dirent* e = readdir(d)) {
+    std::string src = from + "/" + e->d_name;
+    struct stat st;
+    if (e->d_name[0] == '.' || stat(src.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+    std::ifstream in(src, std::ios::binary);
+    std::ofstream out(to + "/" + e->d_name, std::ios::binary);
+    out << in.rdbuf();
+  }
+  closedir(d);
+}
+
+int main(int argc, char** argv) {
+  Options opt;
+  if (!parseOptions(argc, argv, opt)) {
+    usage();
+    return 2;
+  }
+
+  std::unique_ptr<SampleSource> source;
+  if (!opt.replay.empty()) {
+    ReplaySource* replay = new ReplaySource();
+    source.reset(replay);
+    std::string error;
+    if (!replay->load(opt.replay, error)) {
+      fprintf(stderr, "%s: %s\n", opt.replay.c_str(), error.c_str());
+      return 2;
+    }
+  } else {
+    source.reset(new SyntheticSource());
+  }
+
+  std::vector<std::pair<std::string, Profile>> profiles;
+  std::stringstream list(opt.clients);
+  std::string item;
+  while (std::getline(list, item, ',')) {
+    size_t eq = item.find('=');
+    std::string name = item.substr(0, eq);
+    int count = eq == std::string::npos ? 1 : atoi(item.c_str() + eq + 1);
+    Profile p;
+    if (!makeProfile(name, p)) {
+      fprintf(stderr, "Unbekanntes Client-Profil: %s\n", name.c_str());
+      return 2;
+    }
+    for (int i = 0; i < count; i++) profiles.emplace_back(name, p);
+  }
+
+  // Simuliertes SPIFFS vorbereiten
+  std::string fsDir = opt.fsDir.empty() ? "/tmp/loadsim_" + std::to_string(getpid()) : opt.fsDir;
+  SPIFFS.setRoot(fsDir);
+  SPIFFS.format();
+  mkdir(fsDir.c_str(), 0755);
+  copyDataDir(opt.dataDir, fsDir);
+  SPIFFS.capacity = opt.fsKb * 1024;
+  Serial.quiet = !opt.verbose;
+  sim::setHeapBudget(opt.heapKb * 1024);
+
+  Adafruit_ADS1115::source = rawForPressure;
+  ads.present = opt.adcAfter == 0;
+  Wire.devicePresent = [](uint8_t addr) { return addr != 0x48 || ads.present; };
+  currentSample = source->at(0);
+
+  // ----- Firmware starten -----
+  // setup() und die ersten Anfragen laufen in Echtzeit: die Wanduhr des PCs, mit --speed
+  // multipliziert, ergäbe eine Startzeit, die mit dem ESP32 nichts zu tun hat (/api/health)
+  sim::setSpeed(1);
+  {
+    sim::HeapScope firmware(true);
+    setup();
+
+    // Wie der Browser beim ersten Aufruf: Uhr stellen, Aufnahme starten, ggf. Uplink einschalten
+    server.execute(HTTP_GET, "/setTime?t=" + std::to_string((long long)source->startTime()));
+    loop();   // wie auf dem ESP32 kehrt handleClient() in loop() zurück, das stempelt die erste Antwort
+    if (opt.record) {
+      // Solange das SPIFFS eingehängt wird, antwortet die Firmware mit 503 – wie der Browser erneut versuchen
+      while (server.execute(HTTP_GET, "/toggleRecording").code == 503) {
+        loop();
+        sim::sleepVirtual(100);
+      }
+    }
+    if (!opt.uplink.empty()) {
+      server.execute(HTTP_POST, "/api/uplink", {},
+                     "{\"enabled\":true,\"ssid\":\"sim\",\"url\":\"" + opt.uplink + "\",\"station\":\"loadsim\"}");
+    }
+    for (auto& rule : opt.rules) {
+      WebServer::Response r = server.execute(HTTP_POST, "/api/rules", {}, rule);
+      if (r.code != 200) {
+        fprintf(stderr, "Regel abgelehnt (%d: %s): %s\n", r.code, r.body.c_str(), rule.c_str());
+        return 2;
+      }
+    }
+  }
+  sim::setSpeed(opt.speed);
+  currentLog = logFileName.str();
+  for (int s = 0; s < 4; s++) {
+    calibration[s][0] = pressureSensor_V_min[s];
+    calibration[s][1] = pressureSensor_V_max[s];
+    calibration[s][2] = pressureSensor_PSI_min[s];
+    calibration[s][3] = pressureSensor_PSI_max[s];
+  }
+
+  printf("Lastsimulation: %s, %.0fx Echtzeit, %llu s, %zu Clients%s\n", source->describe().c_str(), opt.speed,
+         (unsigned long long)opt.duration, profiles.size(), opt.hammer ? " (ohne Pause)" : "");
+  fflush(stdout);
+
+  std::vector<std::map<std::string, RouteStats>> clientStats(profiles.size());
+  std::vector<std::thread> clients;
+  for (size_t i = 0; i < profiles.size(); i++) {
+    clients.emplace_back(clientThread, profiles[i].second, opt.hammer, &clientStats[i]);
+  }
+
+  // ----- Hauptschleife: Messwerte einspeisen, loop() aufrufen -----
+  uint64_t startMs = sim::nowMs();
+  uint64_t startWallUs = sim::wallUs();
+  uint32_t startSeq = sampleSeq;
+  uint64_t fedSeconds = 0;
+  double pulseRest[2] = {0, 0};
+  uint64_t loops = 0;
+  uint64_t warmHeap = 0;
+  uint64_t lastReport = 0;
+  {
+    sim::HeapScope firmware(true);
+    for (;;) {
+      uint64_t elapsed = sim::nowMs() - startMs;
+      bool lost = opt.adcLost > 0 && elapsed >= opt.adcLost * 1000 && elapsed < opt.adcLost * 1000 + ADC_LOST_MS;
+      ads.present = elapsed >= opt.adcAfter * 1000 && !lost;
+      if (elapsed >= opt.duration * 1000) break;
+
+      // Sobald ein Messzyklus der Firmware fertig ist: Druckwerte und Impulse für den nächsten bereitstellen.
+      // Der Takt richtet sich nach der Firmware (sampleSeq), nicht nach dem Start des Harness.
+      if (fedSeconds <= sampleSeq - startSeq) {
+        currentSample = source->at(fedSeconds++);
+        for (int f = 0; f < 2; f++) {
+          double pulses = currentSample.flow[f] * PULSES_PER_LPM + pulseRest[f];
+          uint32_t n = (uint32_t)pulses;
+          pulseRest[f] = pulses - n;
+          for (uint32_t k = 0; k < n; k++) f == 0 ? flowSensor1ISR() : flowSensor2ISR();
+        }
+      }
+
+      loop();
+      loops++;
+
+      if (warmHeap == 0 && elapsed >= 600000) warmHeap = sim::heapStats().current;   // nach 10 min Anlauf
+      if (elapsed / 600000 != lastReport) {
+        lastReport = elapsed / 600000;
+        sim::HeapStats h = sim::heapStats();
+        fprintf(stderr, "  %4llu min: Heap %s (Spitze %s), Flash %s, Logzeilen %u\n",
+                (unsigned long long)(elapsed / 60000), kb(h.current).c_str(), kb(h.peak).c_str(),
+                kb(SPIFFS.bytesWritten).c_str(), logRowCount);
+      }
+
+      // Bis zum nächsten Messzyklus oder zur nächsten Anfrage warten
+      unsigned long sinceTick = millis() - previousMillis;
+      if (sinceTick < TICK_MS && !server.pending()) server.waitForRequest(sim::wallUsForVirtual(TICK_MS - sinceTick));
+    }
+  }
+  uint64_t virtualMs = sim::nowMs() - startMs;
+  double wallS = (sim::wallUs() - startWallUs) / 1e6;
+  uint32_t samples = sampleSeq - startSeq;
+
+  // Clients beenden; noch wartende Anfragen werden dabei weiter bedient
+  clientsRunning = false;
+  while (clientsFinished < clients.size()) {
+    sim::HeapScope firmware(true);
+    server.handleClient();
+    server.waitForRequest(1000);
+  }
+  for (auto& c : clients) c.join();
+  uint32_t rows = logRowCount;
+  bool wasRecording = recording;
+  if (wasRecording) {
+    sim::HeapScope firmware(true);
+    server.execute(HTTP_GET, "/toggleRecording");
+  }
+
+  // ----- Bericht -----
+  std::map<std::string, RouteStats> total;
+  for (auto& m : clientStats) {
+    for (auto& r : m) total[r.first].merge(r.second);
+  }
+  uint64_t requests = 0, bytes = 0, errors = 0;
+  for (auto& r : total) {
+    requests += r.second.latencyUs.size();
+    bytes += r.second.bytes;
+    errors += r.second.serverErrors;
+  }
+
+  sim::HeapStats heap = sim::heapStats();
+  uint64_t expected = virtualMs / 1000;
+  printf("\nSimuliert %.1f min in %.1f s Wanduhr (%.0fx), %llu Aufrufe von loop()\n", virtualMs / 60000.0, wallS,
+         virtualMs / 1000.0 / wallS, (unsigned long long)loops);
+  printf("Messzyklen: %u von %llu (%lld verpasst), Logzeilen: %u\n", samples, (unsigned long long)expected,
+         (long long)expected - samples, rows);
+  if (expected > 0 && (long long)expected - samples > (long long)expected / 100) {
+    printf("  Hinweis: mehr als 1 %% der Messzyklen verpasst – loop() war blockiert oder --speed ist zu hoch für diesen PC\n");
+  }
+  printf("Durchsatz: %llu Anfragen (%.0f/s), %.1f MB ausgeliefert (%.2f MB/s)\n", (unsigned long long)requests,
+         requests / wallS, bytes / 1048576.0, bytes / 1048576.0 / wallS);
+
+  printf("\n%-22s %8s %6s %6s %6s %9s %9s %9s %9s %9s\n", "Route", "Anfragen", "2xx", "304", "Fehler",
+         "p50 ms", "p90 ms", "p99 ms", "max ms", "Handler");
+  for (auto& r : total) {
+    RouteStats& s = r.second;
+    double p50 = percentileMs(s.latencyUs, 50), p90 = percentileMs(s.latencyUs, 90);
+    double p99 = percentileMs(s.latencyUs, 99), max = percentileMs(s.latencyUs, 100);
+    double service = percentileMs(s.serviceUs, 50);
+    printf("%-22s %8zu %6llu %6llu %6llu %9.2f %9.2f %9.2f %9.2f %9.2f\n", r.first.c_str(), s.latencyUs.size(),
+           (unsigned long long)s.ok, (unsigned long long)s.notModified,
+           (unsigned long long)(s.clientErrors + s.serverErrors), p50, p90, p99, max, service);
+  }
+  printf("(Latenz = Warten in der Queue + Bearbeitung, Wanduhr des PCs; Handler = Median der Bearbeitungszeit)\n");
+
+  printf("\nHeap (Firmware): Spitze %s von %s, am Ende %s, nach 10 min %s, %llu Allokationen, größter Block %s\n",
+         kb(heap.peak).c_str(), kb(heap.budget).c_str(), kb(heap.current).c_str(),
+         warmHeap ? kb(warmHeap).c_str() : "-", (unsigned long long)heap.allocations, kb(heap.largest).c_str());
+  if (heap.overBudget) {
+    printf("  WARNUNG: %llu Allokationen über dem Heap-Budget (auf dem ESP32 fehlgeschlagen)\n",
+           (unsigned long long)heap.overBudget);
+  }
+  double hours = virtualMs / 3600000.0;
+  uint64_t flash = SPIFFS.bytesWritten + Preferences::bytesWritten + EEPROMClass::bytesWritten;
+  printf("Flash geschrieben: %s gesamt (%s/h) – SPIFFS %s, NVS %s (%llu Schreibvorgänge), EEPROM %s\n",
+         kb(flash).c_str(), kb((uint64_t)(flash / hours)).c_str(), kb(SPIFFS.bytesWritten).c_str(),
+         kb(Preferences::bytesWritten).c_str(), (unsigned long long)Preferences::writes.load(),
+         kb(EEPROMClass::bytesWritten).c_str());
+  printf("SPIFFS belegt: %s von %s", kb(SPIFFS.usedBytes()).c_str(), kb(SPIFFS.totalBytes()).c_str());
+  if (SPIFFS.writeFailures) printf(", %llu Schreibfehler (voll)", (unsigned long long)SPIFFS.writeFailures.load());
+  printf("\n");
+  if (!opt.rules.empty()) {
+    printf("Ereignisse: %u, Latenz Messzyklus -> Ereignis max. %.2f ms, -> Client (Push) max. %u ms, "
+           "Auswertung max. %u us\n", eventLastId, eventLatencyUsMax / 1000.0, eventDeliveryMsMax, eventEvalUsMax);
+  }
+  if (!opt.uplink.empty()) printf("Uplink: %u Pakete gesendet, %u verworfen\n", uplinkSent, uplinkDropped);
+  {
+    sim::HeapScope firmware(true);
+    printf("Start (/api/health): %s\n", server.execute(HTTP_GET, "/api/health").body.c_str());
+  }
+
+  fflush(stdout);
+  if (opt.fsDir.empty()) SPIFFS.format(), rmdir(fsDir.c_str());
+  // Firmware-Tasks (Uplink) laufen endlos; ohne Destruktoren beenden
+  _exit(heap.overBudget || errors ? 1 : 0);
+}
@@ -0,0 +1,24 @@
+/*****************************************************
+ * Adafruit_ADS1X15.h (Lastsimulation) – ADC mit Werten aus dem Harness
+ *****************************************************/
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+#include <functional>
+
+typedef enum { GAIN_TWOTHIRDS = 0, GAIN_ONE = 0x0200, GAIN_TWO = 0x0400, GAIN_FOUR = 0x0600 } adsGain_t;
+
+// Simulierter ADS1115: Rohwerte kommen aus einer vom Harness gesetzten Quelle
+class Adafruit_ADS1115 {
+public:
+  bool begin(uint8_t addr = 0x48, TwoWire* wire = &Wire) { (void)addr; (void)wire; return present; }
+  void setGain(adsGain_t g) { _gain = g; }
+  int16_t readADC_SingleEnded(uint8_t channel);
+  float computeVolts(int16_t counts) { return counts * 0.000125f; }
+  // Simulation
+  static std::function<int16_t(uint8_t)> source;
+  static std::atomic<uint64_t> conversions;
+  bool present = true;
+private:
+  adsGain_t _gain = GAIN_ONE;
+};
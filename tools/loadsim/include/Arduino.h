@@ -0,0 +1,163 @@
+/*****************************************************
+ * Arduino.h (Lastsimulation) – Ersatz für den Arduino-Kern auf dem PC
+ *
+ * Stellt nur das bereit, was src/main.cpp benutzt. millis()/delay() laufen
+ * auf der virtuellen Uhr des Harness (siehe tools/loadsim/sim.h).
+ *****************************************************/
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+#include <algorithm>
+#include <new>
+#include <atomic>
+#include <sys/time.h>
+
+#define IRAM_ATTR
+#define INPUT 0x01
+#define INPUT_PULLUP 0x05
+#define OUTPUT 0x03
+#define FALLING 0x02
+#define RISING 0x01
+#define HIGH 1
+#define LOW 0
+typedef bool boolean;
+typedef uint8_t byte;
+
+class String {
+public:
+  String() {}
+  String(const char* s) : _s(s ? s : "") {}
+  String(const std::string& s) : _s(s) {}
+  String(char c) : _s(1, c) {}
+  String(int v) : _s(std::to_string(v)) {}
+  String(unsigned int v) : _s(std::to_string(v)) {}
+  String(long v) : _s(std::to_string(v)) {}
+  String(unsigned long v) : _s(std::to_string(v)) {}
+  String(long long v) : _s(std::to_string(v)) {}
+  String(unsigned long long v) : _s(std::to_string(v)) {}
+  String(float v, unsigned int decimals = 2) { fmt(v, decimals); }
+  String(double v, unsigned int decimals = 2) { fmt(v, decimals); }
+  unsigned int length() const { return (unsigned int)_s.size(); }
+  const char* c_str() const { return _s.c_str(); }
+  bool reserve(unsigned int n) { _s.reserve(n); return true; }
+  String& operator+=(const String& o) { _s += o._s; return *this; }
+  String& operator+=(const char* o) { _s += o; return *this; }
+  String& operator+=(char c) { _s += c; return *this; }
+  String& operator+=(int v) { _s += std::to_string(v); return *this; }
+  String& operator+=(unsigned int v) { _s += std::to_string(v); return *this; }
+  String& operator+=(long v) { _s += std::to_string(v); return *this; }
+  String& operator+=(unsigned long v) { _s += std::to_string(v); return *this; }
+  bool concat(const char* s, unsigned int n) { _s.append(s, n); return true; }
+  bool concat(const String& s) { _s += s._s; return true; }
+  bool concat(char c) { _s += c; return true; }
+  friend String operator+(const String& a, const String& b) { return String(a._s + b._s); }
+  friend String operator+(const String& a, const char* b) { return String(a._s + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b._s); }
+  friend String operator+(const String& a, char b) { return String(a._s + b); }
+  bool operator==(const String& o) const { return _s == o._s; }
+  bool operator==(const char* o) const { return _s == o; }
+  bool operator!=(const String& o) const { return _s != o._s; }
+  bool operator!=(const char* o) const { return _s != o; }
+  bool operator<(const String& o) const { return _s < o._s; }
+  char operator[](unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+  char charAt(unsigned int i) const { return (*this)[i]; }
+  bool startsWith(const String& p) const { return _s.compare(0, p._s.size(), p._s) == 0; }
+  bool endsWith(const String& p) const { return _s.size() >= p._s.size() && _s.compare(_s.size() - p._s.size(), p._s.size(), p._s) == 0; }
+  int indexOf(char c, unsigned int from = 0) const { auto p = _s.find(c, from); return p == std::string::npos ? -1 : (int)p; }
+  int indexOf(const String& t, unsigned int from = 0) const { auto p = _s.find(t._s, from); return p == std::string::npos ? -1 : (int)p; }
+  int lastIndexOf(char c) const { auto p = _s.rfind(c); return p == std::string::npos ? -1 : (int)p; }
+  String substring(unsigned int from) const { return from >= _s.size() ? String() : String(_s.substr(from)); }
+  String substring(unsigned int from, unsigned int to) const { if (from > to) std::swap(from, to); if (from >= _s.size()) return String(); return String(_s.substr(from, to - from)); }
+  void replace(char a, char b) { std::replace(_s.begin(), _s.end(), a, b); }
+  void replace(const String& a, const String& b) { if (a._s.empty()) return; size_t p = 0; while ((p = _s.find(a._s, p)) != std::string::npos) { _s.replace(p, a._s.size(), b._s); p += b._s.size(); } }
+  void trim() { size_t a = _s.find_first_not_of(" \t\r\n"); if (a == std::string::npos) { _s.clear(); return; } size_t b = _s.find_last_not_of(" \t\r\n"); _s = _s.substr(a, b - a + 1); }
+  void toLowerCase() { for (auto& c : _s) c = (char)tolower(c); }
+  long toInt() const { return strtol(_s.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(_s.c_str(), nullptr); }
+  double toDouble() const { return strtod(_s.c_str(), nullptr); }
+  const std::string& str() const { return _s; }
+private:
+  void fmt(double v, unsigned int d) { char b[64]; snprintf(b, sizeof(b), "%.*f", (int)d, v); _s = b; }
+  std::string _s;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) { return write(&c, 1); }
+  virtual size_t write(const uint8_t* buf, size_t n) = 0;
+  size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+  size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(char c) { return write((const uint8_t*)&c, 1); }
+  size_t print(int v) { return print(String(v)); }
+  size_t print(unsigned int v) { return print(String(v)); }
+  size_t print(long v) { return print(String(v)); }
+  size_t print(unsigned long v) { return print(String(v)); }
+  size_t print(double v, int d = 2) { return print(String(v, d)); }
+  size_t println() { return print("\n"); }
+  template <typename T> size_t println(const T& v) { size_t n = print(v); return n + print("\n"); }
+  size_t println(double v, int d) { size_t n = print(v, d); return n + print("\n"); }
+  size_t printf(const char* f, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() { return -1; }
+  size_t readBytes(uint8_t* buf, size_t n) { size_t i = 0; while (i < n) { int c = read(); if (c < 0) break; buf[i++] = (uint8_t)c; } return i; }
+  size_t readBytesUntil(char term, char* buf, size_t n) { size_t i = 0; while (i < n) { int c = read(); if (c < 0 || c == term) break; buf[i++] = (char)c; } return i; }
+  String readStringUntil(char term) { std::string s; int c; while ((c = read()) >= 0 && c != term) s += (char)c; return String(s); }
+};
+
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  size_t write(const uint8_t* buf, size_t n) override;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  bool quiet = true;                   // Debug-Ausgaben der Firmware unterdrücken (--verbose)
+};
+extern HardwareSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+void noInterrupts();
+void interrupts();
+#define digitalPinToInterrupt(p) (p)
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void configTime(long gmtOffset, int daylightOffset, const char* server1, const char* server2 = nullptr, const char* server3 = nullptr);
+
+// ESP32-spezifische Attribute / Systemfunktionen
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define __NOINIT_ATTR
+typedef enum { ESP_RST_UNKNOWN, ESP_RST_POWERON, ESP_RST_EXT, ESP_RST_SW, ESP_RST_PANIC, ESP_RST_INT_WDT, ESP_RST_TASK_WDT, ESP_RST_WDT, ESP_RST_DEEPSLEEP, ESP_RST_BROWNOUT, ESP_RST_SDIO } esp_reset_reason_t;
+esp_reset_reason_t esp_reset_reason();
+class EspClass {
+public:
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getHeapSize() { return 320 * 1024; }
+  uint32_t getMaxAllocHeap() { return getFreeHeap(); }
+  void restart();
+};
+extern EspClass ESP;
+
+template <typename T, typename L, typename H> T constrain(T v, L lo, H hi) { return v < lo ? (T)lo : (v > hi ? (T)hi : v); }
+inline bool isDigit(int c) { return c >= '0' && c <= '9'; }   // WCharacter.h
+inline long random(long howbig) { return howbig > 0 ? ::random() % howbig : 0; }   // WMath.cpp
+
+// FreeRTOS-Ersatz (Tasks = std::thread, Queues = Mutex + Condition Variable)
+#include <freertos_shim.h>
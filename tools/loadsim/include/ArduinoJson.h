@@ -0,0 +1,42 @@
+/*****************************************************
+ * ArduinoJson.h (Lastsimulation) – flache JSON-Objekte für die POST-Handler
+ *****************************************************/
+#pragma once
+#include <Arduino.h>
+#include <map>
+
+// Sehr kleiner Ersatz für ArduinoJson (nur flache Objekte mit Zahlen/Strings)
+class JsonVariant {
+public:
+  JsonVariant(const std::string* v = nullptr) : _v(v) {}
+  operator int() const { return _v ? atoi(_v->c_str()) : 0; }
+  operator long() const { return _v ? atol(_v->c_str()) : 0; }
+  operator float() const { return _v ? strtof(_v->c_str(), nullptr) : 0.0f; }
+  operator double() const { return _v ? strtod(_v->c_str(), nullptr) : 0.0; }
+  operator bool() const { return _v && (*_v == "true" || atoi(_v->c_str()) != 0); }
+  operator String() const { return _v ? String(*_v) : String(); }
+  template <typename T> T as() const { return (T)(*this); }
+  bool isNull() const { return !_v; }
+private:
+  const std::string* _v;
+};
+
+class DynamicJsonDocument {
+public:
+  explicit DynamicJsonDocument(size_t) {}
+  JsonVariant operator[](const char* key) const { auto it = _values.find(key); return it == _values.end() ? JsonVariant() : JsonVariant(&it->second); }
+  bool containsKey(const char* key) const { return _values.count(key) > 0; }
+  std::map<std::string, std::string> _values;
+};
+typedef DynamicJsonDocument StaticJsonDocumentBase;
+
+class DeserializationError {
+public:
+  enum Code { Ok, InvalidInput };
+  DeserializationError(Code c = Ok) : _c(c) {}
+  explicit operator bool() const { return _c != Ok; }
+  const char* c_str() const { return _c == Ok ? "Ok" : "InvalidInput"; }
+private:
+  Code _c;
+};
+DeserializationError deserializeJson(DynamicJsonDocument& doc, const String& input);
@@ -0,0 +1,22 @@
+/*****************************************************
+ * EEPROM.h (Lastsimulation) – emuliertes EEPROM im RAM
+ *****************************************************/
+#pragma once
+#include <Arduino.h>
+#include <vector>
+#include <atomic>
+class EEPROMClass {
+public:
+  bool begin(size_t size) { if (_data.size() < size) _data.resize(size, 0xFF); return true; }
+  template <typename T> T& get(int addr, T& t) { if (addr + sizeof(T) <= _data.size()) memcpy(&t, &_data[addr], sizeof(T)); return t; }
+  template <typename T> const T& put(int addr, const T& t) { if (addr + sizeof(T) <= _data.size()) memcpy(&_data[addr], &t, sizeof(T)); return t; }
+  bool commit();
+  uint8_t read(int a) { return _data[a]; }
+  void write(int a, uint8_t v) { _data[a] = v; }
+  // Simulation: bei jedem commit() geschriebene Bytes
+  static std::atomic<uint64_t> bytesWritten;
+private:
+  std::vector<uint8_t> _data;
+  std::vector<uint8_t> _committed;   // Stand im (simulierten) NVS
+};
+extern EEPROMClass EEPROM;
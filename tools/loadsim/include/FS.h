@@ -0,0 +1,63 @@
+/*****************************************************
+ * FS.h (Lastsimulation) – Dateien im simulierten Flash
+ *****************************************************/
+#pragma once
+#include <Arduino.h>
+#include <memory>
+#include <vector>
+#include <atomic>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+namespace fs {
+class FSImpl;
+
+// Datei im simulierten Flash (Host-Verzeichnis); geschriebene Bytes werden gezählt
+class File : public Stream {
+public:
+  File() {}
+  size_t write(const uint8_t* buf, size_t n) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t read(uint8_t* buf, size_t n);
+  bool seek(uint32_t pos, SeekMode mode = SeekSet);
+  size_t position() const;
+  size_t size() const;
+  void close();
+  void flush();
+  explicit operator bool() const { return (bool)_h; }
+  const char* name() const;
+  const char* path() const;
+  bool isDirectory() const;
+  File openNextFile(const char* mode = FILE_READ);
+  time_t getLastWrite();
+  struct Handle;
+  std::shared_ptr<Handle> _h;
+};
+
+class FS {
+public:
+  File open(const String& path, const char* mode = FILE_READ, bool create = false);
+  File open(const char* path, const char* mode = FILE_READ, bool create = false) { return open(String(path), mode, create); }
+  bool exists(const String& path);
+  bool remove(const String& path);
+  bool rename(const String& from, const String& to);
+  // Simulation
+  void setRoot(const std::string& dir) { _root = dir; }
+  std::string hostPath(const String& path) const;
+  std::string root() const { return _root; }
+  std::atomic<int64_t>  used{0};           // belegte Bytes (Summe der Dateigrößen)
+  std::atomic<uint64_t> bytesWritten{0};   // Summe aller geschriebenen Bytes (Flash-Verschleiß)
+  std::atomic<uint64_t> writeFailures{0};  // Schreibversuche bei vollem Dateisystem
+  size_t capacity = 1374476;               // nutzbare Größe der Standard-SPIFFS-Partition
+protected:
+  std::string _root = "/tmp/flowsim_fs";
+};
+}  // namespace fs
+using fs::File;
+using fs::FS;
@@ -0,0 +1,28 @@
+/*****************************************************
+ * HTTPClient.h (Lastsimulation) – HTTP-Client über Sockets des PCs
+ *****************************************************/
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+
+#define HTTP_CODE_OK 200
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+
+// Minimaler HTTP/1.0-Client über echte Sockets (für Tests gegen einen lokalen Mock-Collector)
+class HTTPClient {
+public:
+  bool begin(const String& url);
+  void addHeader(const String& name, const String& value);
+  void setTimeout(uint16_t ms) { _timeoutMs = ms; }
+  void setConnectTimeout(int32_t ms) { _timeoutMs = ms; }
+  int POST(const uint8_t* payload, size_t size);
+  int POST(const String& payload) { return POST((const uint8_t*)payload.c_str(), payload.length()); }
+  int GET();
+  String getString() { return String(_body); }
+  void end() {}
+private:
+  int request(const char* method, const uint8_t* payload, size_t size);
+  std::string _host, _path, _headers, _body;
+  int _port = 80;
+  int _timeoutMs = 5000;
+};
@@ -0,0 +1,37 @@
+/*****************************************************
+ * Preferences.h (Lastsimulation) – NVS im RAM
+ *****************************************************/
+#pragma once
+#include <Arduino.h>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+// Simulierter NVS-Namensraum (im RAM, geschriebene Bytes werden gezählt)
+class Preferences {
+public:
+  bool begin(const char* name, bool readOnly = false) { _ns = name; (void)readOnly; return true; }
+  void end() {}
+  bool clear();
+  bool remove(const char* key);
+  bool isKey(const char* key);
+  size_t putBytes(const char* key, const void* value, size_t len);
+  size_t getBytes(const char* key, void* buf, size_t maxLen);
+  size_t getBytesLength(const char* key);
+  size_t putUInt(const char* key, uint32_t v) { return putBytes(key, &v, sizeof(v)); }
+  uint32_t getUInt(const char* key, uint32_t def = 0) { uint32_t v = def; getBytes(key, &v, sizeof(v)); return v; }
+  size_t putULong64(const char* key, uint64_t v) { return putBytes(key, &v, sizeof(v)); }
+  uint64_t getULong64(const char* key, uint64_t def = 0) { uint64_t v = def; getBytes(key, &v, sizeof(v)); return v; }
+  size_t putString(const char* key, const String& v) { return putBytes(key, v.c_str(), v.length() + 1); }
+  String getString(const char* key, const String& def = String());
+  size_t putBool(const char* key, bool v) { uint8_t b = v; return putBytes(key, &b, 1); }
+  bool getBool(const char* key, bool def = false) { uint8_t b = def; getBytes(key, &b, 1); return b; }
+  size_t putFloat(const char* key, float v) { return putBytes(key, &v, sizeof(v)); }
+  float getFloat(const char* key, float def = NAN) { float v = def; getBytes(key, &v, sizeof(v)); return v; }
+  // Simulation
+  static std::atomic<uint64_t> bytesWritten;
+  static std::atomic<uint64_t> writes;
+private:
+  std::string _ns;
+};
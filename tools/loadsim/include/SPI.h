@@ -0,0 +1,3 @@
+// SPI.h (Lastsimulation) – alles Nötige steht in Arduino.h
+#pragma once
+#include <Arduino.h>
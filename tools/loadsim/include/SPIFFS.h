@@ -0,0 +1,18 @@
+/*****************************************************
+ * SPIFFS.h (Lastsimulation) – Flash-Dateisystem in einem Host-Verzeichnis
+ *****************************************************/
+#pragma once
+#include <FS.h>
+#include <atomic>
+
+class SPIFFSFS : public fs::FS {
+public:
+  bool begin(bool formatOnFail = false, const char* basePath = "/spiffs", uint8_t maxOpenFiles = 10, const char* label = nullptr);
+  bool format();
+  void end() {}
+  size_t totalBytes() { return capacity; }
+  size_t usedBytes() { return used > 0 ? (size_t)used : 0; }
+  // Simulation
+  bool failBegin = false;
+};
+extern SPIFFSFS SPIFFS;
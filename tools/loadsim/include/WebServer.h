@@ -0,0 +1,115 @@
+/*****************************************************
+ * WebServer.h (Lastsimulation) – WebServer ohne Netzwerk
+ *
+ * Client-Threads reihen Anfragen ein, die Firmware arbeitet sie wie auf dem
+ * ESP32 nacheinander in handleClient() ab.
+ *****************************************************/
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include <WiFi.h>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+class WebServer;
+
+// Wie detail/RequestHandler.h von Arduino-ESP32 2.x (nur canHandle/handle)
+class RequestHandler {
+public:
+  virtual ~RequestHandler() {}
+  virtual bool canHandle(HTTPMethod method, String uri) { (void)method; (void)uri; return false; }
+  virtual bool handle(WebServer& server, HTTPMethod method, String uri) { (void)server; (void)method; (void)uri; return false; }
+};
+
+class WebServer {
+public:
+  typedef std::function<void()> THandlerFunction;
+
+  struct Response {
+    int code = 0;
+    std::string contentType;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+    uint64_t queuedUs = 0;     // Wartezeit in der Queue (Wanduhr)
+    uint64_t serviceUs = 0;    // Bearbeitungszeit im Handler (Wanduhr)
+    std::shared_ptr<WiFiPipe> pipe;  // offen, wenn der Handler die Verbindung übernommen hat (z. B. SSE)
+    std::string header(const std::string& key) const;
+  };
+
+  explicit WebServer(int port = 80) { (void)port; }
+  void on(const String& uri, HTTPMethod method, THandlerFunction fn);
+  void on(const String& uri, THandlerFunction fn) { on(uri, HTTP_ANY, fn); }
+  void onNotFound(THandlerFunction fn) { _notFound = fn; }
+  void addHandler(RequestHandler* handler) { _handlers.push_back(handler); }
+  void begin() {}
+  void handleClient();
+  void collectHeaders(const char* keys[], size_t count);
+
+  bool hasArg(const String& name) const;
+  String arg(const String& name) const;
+  int args() const { return (int)_args.size(); }
+  bool hasHeader(const String& name) const;
+  String header(const String& name) const;
+  String uri() const { return String(_uri); }
+  HTTPMethod method() const { return _method; }
+
+  void sendHeader(const String& name, const String& value, bool first = false);
+  void setContentLength(size_t len) { _contentLength = len; }
+  void send(int code, const char* contentType = nullptr, const String& content = String());
+  void send(int code, const String& contentType, const String& content) { send(code, contentType.c_str(), content); }
+  void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+  void sendContent(const char* data, size_t len);
+  template <typename T> size_t streamFile(T& file, const String& contentType) {
+    setContentLength(file.size());
+    send(200, contentType.c_str(), String());
+    uint8_t buf[512];
+    size_t total = 0, n;
+    while ((n = file.read(buf, sizeof(buf))) > 0) { sendContent((const char*)buf, n); total += n; }
+    return total;
+  }
+  WiFiClient client() { return _client; }
+
+  // --- Simulation ---
+  // Blockiert, bis die Anfrage in handleClient() bearbeitet wurde (für Client-Threads)
+  Response request(HTTPMethod method, const std::string& uriWithQuery,
+                   const std::map<std::string, std::string>& headers = {}, const std::string& body = "");
+  // Bearbeitet eine Anfrage direkt im aufrufenden Thread
+  Response execute(HTTPMethod method, const std::string& uriWithQuery,
+                   const std::map<std::string, std::string>& headers = {}, const std::string& body = "");
+  size_t pending();
+  // Wartet (Wanduhr) auf eine neue Anfrage; true, wenn eine ansteht
+  bool waitForRequest(uint64_t maxWaitUs);
+
+private:
+  struct Route { std::string uri; HTTPMethod method; THandlerFunction fn; };
+  struct Job {
+    HTTPMethod method; std::string uri; std::map<std::string, std::string> headers; std::string body;
+    Response response; bool done = false; uint64_t enqueuedUs = 0;
+  };
+  void dispatch(Job& job);
+
+  std::vector<Route> _routes;
+  std::vector<RequestHandler*> _handlers;      // werden wie auf dem ESP32 vor den Routen gefragt
+  THandlerFunction _notFound;
+  std::vector<std::string> _collect;
+  std::vector<std::pair<std::string, std::string>> _args;
+  std::map<std::string, std::string> _headers;
+  std::string _uri;
+  HTTPMethod _method = HTTP_GET;
+  size_t _contentLength = CONTENT_LENGTH_NOT_SET;
+  std::vector<std::pair<std::string, std::string>> _pendingHeaders;
+  Response* _current = nullptr;
+  WiFiClient _client;
+
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::deque<Job*> _queue;
+};
@@ -0,0 +1,74 @@
+/*****************************************************
+ * WiFi.h (Lastsimulation) – Access Point/Station ohne Funk
+ *****************************************************/
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+class IPAddress {
+public:
+  IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) { _b[0] = a; _b[1] = b; _b[2] = c; _b[3] = d; }
+  String toString() const { char s[16]; snprintf(s, sizeof(s), "%u.%u.%u.%u", _b[0], _b[1], _b[2], _b[3]); return String(s); }
+  operator String() const { return toString(); }
+private:
+  uint8_t _b[4];
+};
+
+// Gemeinsamer Puffer einer (simulierten) Verbindung: die Firmware schreibt, der Client-Thread liest
+struct WiFiPipe {
+  std::mutex mutex;
+  std::string data;
+  std::atomic<bool> open{true};
+  std::string take() { std::lock_guard<std::mutex> lock(mutex); std::string s; s.swap(data); return s; }
+};
+
+// Verbindung zu einem (simulierten) Client; Daten werden in einem gemeinsamen Puffer gesammelt
+class WiFiClient : public Stream {
+public:
+  WiFiClient() {}
+  size_t write(const uint8_t* buf, size_t n) override {
+    if (!connected()) return 0;
+    std::lock_guard<std::mutex> lock(_pipe->mutex);
+    _pipe->data.append((const char*)buf, n);
+    return n;
+  }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  bool connected() const { return _pipe && _pipe->open; }
+  void stop() { if (_pipe) _pipe->open = false; }
+  explicit operator bool() const { return connected(); }
+  void setNoDelay(bool) {}
+  // Simulation
+  static WiFiClient attach(std::shared_ptr<WiFiPipe> pipe) { WiFiClient c; c._pipe = pipe; return c; }
+private:
+  std::shared_ptr<WiFiPipe> _pipe;
+};
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+typedef enum { WL_IDLE_STATUS = 0, WL_NO_SSID_AVAIL = 1, WL_CONNECTED = 3, WL_CONNECT_FAILED = 4, WL_DISCONNECTED = 6 } wl_status_t;
+
+class WiFiClass {
+public:
+  bool mode(wifi_mode_t m) { _mode = m; return true; }
+  wifi_mode_t getMode() const { return _mode; }
+  bool softAPConfig(IPAddress, IPAddress, IPAddress) { return true; }
+  bool softAP(const char*, const char* = nullptr) { return true; }
+  IPAddress softAPIP() const { return IPAddress(192, 168, 1, 1); }
+  wl_status_t begin(const char*, const char* = nullptr) { _status = WL_CONNECTED; return _status; }
+  wl_status_t status() const { return _status; }
+  bool reconnect() { _status = WL_CONNECTED; return true; }
+  bool disconnect(bool = false) { _status = WL_DISCONNECTED; return true; }
+  bool setAutoReconnect(bool) { return true; }
+  IPAddress localIP() const { return IPAddress(127, 0, 0, 1); }
+  int8_t RSSI() const { return -50; }
+  String macAddress() const { return String("24:0A:C4:00:00:01"); }
+  // Simulation
+  void simulateStatus(wl_status_t s) { _status = s; }
+private:
+  wifi_mode_t _mode = WIFI_OFF;
+  wl_status_t _status = WL_DISCONNECTED;
+};
+extern WiFiClass WiFi;
@@ -0,0 +1,19 @@
+/*****************************************************
+ * Wire.h (Lastsimulation) – I²C ohne Funktion
+ *****************************************************/
+#pragma once
+#include <Arduino.h>
+#include <functional>
+class TwoWire {
+public:
+  bool begin(int sda = -1, int scl = -1, uint32_t freq = 0) { (void)sda; (void)scl; (void)freq; return true; }
+  void setTimeOut(uint16_t) {}
+  void beginTransmission(uint8_t addr) { _addr = addr; }
+  // 0 = Gerät hat quittiert, 2 = keine Antwort auf die Adresse (wie beim ESP32-Core)
+  uint8_t endTransmission(bool stop = true) { (void)stop; return !devicePresent || devicePresent(_addr) ? 0 : 2; }
+  // Simulation: welche Adressen antworten (nicht gesetzt = alle)
+  std::function<bool(uint8_t)> devicePresent;
+private:
+  uint8_t _addr = 0;
+};
+extern TwoWire Wire;
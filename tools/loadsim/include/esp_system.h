@@ -0,0 +1,3 @@
+// esp_system.h (Lastsimulation) – alles Nötige steht in Arduino.h
+#pragma once
+#include <Arduino.h>
@@ -0,0 +1,54 @@
+/*****************************************************
+ * sim.h – Schnittstelle zwischen Harness und simulierter Hardware
+ *
+ * Virtuelle Uhr:
+ *   millis(), delay(), time() und die FreeRTOS-Wartezeiten laufen um den
+ *   Faktor speed schneller als die Wanduhr. time() beginnt wie auf dem
+ *   ESP32 bei 1970, bis die Firmware per settimeofday() gestellt wird.
+ *
+ * Heap:
+ *   Gezählt werden nur Allokationen aus Firmware-Threads (setup/loop und
+ *   FreeRTOS-Tasks). Die Werte sind eine Näherung – std::string und die
+ *   Container des Harness verhalten sich nicht exakt wie Arduino-String und
+ *   der ESP-IDF-Heap – zeigen aber Spitzen und Lecks zuverlässig.
+ *****************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace sim {
+
+// --- Uhr ---
+void     setSpeed(double speed);           // virtuelle ms pro ms Wanduhr (ab jetzt, ohne Sprung)
+double   speed();
+uint64_t nowMs();                          // virtuelle ms seit Start
+uint64_t wallUs();                         // Wanduhr in µs seit Start
+void     sleepVirtual(uint64_t ms);        // schläft ms/speed auf der Wanduhr
+uint64_t wallUsForVirtual(uint64_t ms);    // Umrechnung virtuelle ms -> µs Wanduhr
+
+// --- Neustart ---
+void     setResetReason(int reason);       // Ergebnis von esp_reset_reason() (esp_reset_reason_t, Standard: Einschalten)
+
+// --- Heap ---
+struct HeapStats {
+  uint64_t current;       // aktuell belegte Bytes (Firmware)
+  uint64_t peak;          // Höchststand
+  uint64_t allocations;   // Anzahl Allokationen
+  uint64_t largest;       // größter einzelner Block
+  uint64_t overBudget;    // Allokationen, die auf dem ESP32 fehlgeschlagen wären
+  uint64_t budget;        // freier Heap des ESP32 nach dem Start (Vorgabe)
+};
+HeapStats heapStats();
+void setHeapBudget(uint64_t bytes);
+
+// Zählt Allokationen im aktuellen Thread (true) oder nicht (false), solange das Objekt lebt
+class HeapScope {
+public:
+  explicit HeapScope(bool count);
+  ~HeapScope();
+private:
+  bool _previous;
+};
+
+}  // namespace sim
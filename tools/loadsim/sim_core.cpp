@@ -0,0 +1,348 @@
+/*****************************************************
+ * sim_core.cpp – Uhr, GPIO, Heap-Zählung und FreeRTOS für die Lastsimulation
+ *****************************************************/
+#include "sim.h"
+
+#include <Arduino.h>
+#include <Adafruit_ADS1X15.h>
+#include <Wire.h>
+#include <WiFi.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <malloc.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+TwoWire Wire;
+WiFiClass WiFi;
+
+/* ====================================================
+ * Virtuelle Uhr
+ * ==================================================== */
+static const auto wallStart = std::chrono::steady_clock::now();
+static std::atomic<double> clockSpeed{1.0};
+static std::atomic<int64_t> epochOffset{0};   // Unix-Zeit bei virtueller Zeit 0
+static std::mutex clockMutex;
+static uint64_t clockBaseWallUs = 0;           // Wanduhr beim letzten setSpeed()
+static uint64_t clockBaseVirtualUs = 0;        // virtuelle Zeit beim letzten setSpeed()
+
+namespace sim {
+
+// Die virtuelle Uhr läuft ab dem Umschalten mit der neuen Geschwindigkeit weiter (kein Sprung)
+void setSpeed(double s) {
+  std::lock_guard<std::mutex> lock(clockMutex);
+  uint64_t wall = wallUs();
+  clockBaseVirtualUs += (uint64_t)((wall - clockBaseWallUs) * clockSpeed);
+  clockBaseWallUs = wall;
+  clockSpeed = s > 0 ? s : 1.0;
+}
+
+double speed() {
+  return clockSpeed;
+}
+
+uint64_t wallUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - wallStart).count();
+}
+
+static uint64_t virtualUs() {
+  std::lock_guard<std::mutex> lock(clockMutex);
+  return clockBaseVirtualUs + (uint64_t)((wallUs() - clockBaseWallUs) * clockSpeed);
+}
+
+uint64_t nowMs() {
+  return virtualUs() / 1000;
+}
+
+uint64_t wallUsForVirtual(uint64_t ms) {
+  return (uint64_t)(ms * 1000.0 / clockSpeed);
+}
+
+void sleepVirtual(uint64_t ms) {
+  std::this_thread::sleep_for(std::chrono::microseconds(wallUsForVirtual(ms)));
+}
+
+}  // namespace sim
+
+unsigned long millis() {
+  return (unsigned long)sim::nowMs();
+}
+
+unsigned long micros() {
+  return (unsigned long)sim::virtualUs();
+}
+
+void delay(unsigned long ms) {
+  sim::sleepVirtual(ms);
+}
+
+void yield() {
+  std::this_thread::yield();
+}
+
+// time() und settimeofday() der libc werden für das ganze Programm ersetzt, damit die Firmware
+// die virtuelle Uhr sieht und nicht die Systemzeit des PCs verstellt.
+extern "C" time_t time(time_t* out) __THROW {
+  time_t t = (time_t)(epochOffset + (int64_t)(sim::nowMs() / 1000));
+  if (out) *out = t;
+  return t;
+}
+
+extern "C" int settimeofday(const struct timeval* tv, const struct timezone*) __THROW {
+  if (tv) epochOffset = (int64_t)tv->tv_sec - (int64_t)(sim::nowMs() / 1000);
+  return 0;
+}
+
+void configTime(long, int, const char*, const char*, const char*) {}
+
+/* ====================================================
+ * Serial, GPIO, System
+ * ==================================================== */
+size_t HardwareSerial::write(const uint8_t* buf, size_t n) {
+  if (!quiet) fwrite(buf, 1, n, stdout);
+  return n;
+}
+
+size_t Print::printf(const char* fmt, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  if (n < 0) return 0;
+  return write((const uint8_t*)buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+}
+
+// Die Impulse der Durchflusssensoren erzeugt der Harness, indem er die ISRs der Firmware direkt aufruft
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return HIGH; }
+void noInterrupts() {}
+void interrupts() {}
+void attachInterrupt(uint8_t, void (*)(), int) {}
+
+std::function<int16_t(uint8_t)> Adafruit_ADS1115::source;
+std::atomic<uint64_t> Adafruit_ADS1115::conversions{0};
+
+int16_t Adafruit_ADS1115::readADC_SingleEnded(uint8_t channel) {
+  conversions++;
+  return source ? source(channel) : 0;
+}
+
+static std::atomic<int> resetReason{ESP_RST_POWERON};
+
+void sim::setResetReason(int reason) {
+  resetReason = reason;
+}
+
+esp_reset_reason_t esp_reset_reason() {
+  return (esp_reset_reason_t)resetReason.load();
+}
+
+uint32_t EspClass::getFreeHeap() {
+  sim::HeapStats h = sim::heapStats();
+  return h.current < h.budget ? (uint32_t)(h.budget - h.current) : 0;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+  sim::HeapStats h = sim::heapStats();
+  return h.peak < h.budget ? (uint32_t)(h.budget - h.peak) : 0;
+}
+
+void EspClass::restart() {
+  fprintf(stderr, "ESP.restart() aufgerufen – Simulation wird beendet\n");
+  fflush(stdout);
+  _exit(3);
+}
+
+/* ====================================================
+ * Heap-Zählung
+ * ==================================================== */
+static thread_local bool countHeap = false;
+static std::atomic<uint64_t> heapCurrent{0}, heapPeak{0}, heapAllocations{0}, heapLargest{0}, heapOverBudget{0};
+static std::atomic<uint64_t> heapBudget{160 * 1024};
+
+// Vor jedem Block liegt ein Kopf mit Größe und Zähl-Flag (16 Byte, damit die Ausrichtung erhalten bleibt)
+struct alignas(16) BlockHeader {
+  uint64_t size;
+  uint64_t counted;
+};
+
+static void* heapAlloc(size_t size, bool nothrow) {
+  bool counted = countHeap;
+  if (counted) {
+    uint64_t now = heapCurrent.load();
+    if (now + size > heapBudget) {
+      heapOverBudget++;
+      if (nothrow) return nullptr;   // wie malloc() auf dem ESP32 bei erschöpftem Heap
+    }
+  }
+  BlockHeader* h = (BlockHeader*)malloc(sizeof(BlockHeader) + size);
+  if (!h) {
+    if (nothrow) return nullptr;
+    throw std::bad_alloc();
+  }
+  h->size = size;
+  h->counted = counted;
+  if (counted) {
+    uint64_t now = heapCurrent += size;
+    uint64_t peak = heapPeak.load();
+    while (now > peak && !heapPeak.compare_exchange_weak(peak, now)) {}
+    uint64_t largest = heapLargest.load();
+    while (size > largest && !heapLargest.compare_exchange_weak(largest, size)) {}
+    heapAllocations++;
+  }
+  return h + 1;
+}
+
+static void heapFree(void* p) {
+  if (!p) return;
+  BlockHeader* h = (BlockHeader*)p - 1;
+  if (h->counted) heapCurrent -= h->size;
+  free(h);
+}
+
+void* operator new(size_t size) { return heapAlloc(size, false); }
+void* operator new[](size_t size) { return heapAlloc(size, false); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return heapAlloc(size, true); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return heapAlloc(size, true); }
+void operator delete(void* p) noexcept { heapFree(p); }
+void operator delete[](void* p) noexcept { heapFree(p); }
+void operator delete(void* p, size_t) noexcept { heapFree(p); }
+void operator delete[](void* p, size_t) noexcept { heapFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { heapFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { heapFree(p); }
+
+namespace sim {
+
+HeapStats heapStats() {
+  return {heapCurrent, heapPeak, heapAllocations, heapLargest, heapOverBudget, heapBudget};
+}
+
+void setHeapBudget(uint64_t bytes) {
+  heapBudget = bytes;
+}
+
+HeapScope::HeapScope(bool count) : _previous(countHeap) {
+  countHeap = count;
+}
+
+HeapScope::~HeapScope() {
+  countHeap = _previous;
+}
+
+}  // namespace sim
+
+/* ====================================================
+ * FreeRTOS (Tasks = Threads, Ticks = virtuelle ms)
+ * ==================================================== */
+struct SimTask {
+  std::thread thread;
+};
+
+struct SimQueue {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::vector<uint8_t>> items;
+  UBaseType_t length;
+  UBaseType_t itemSize;
+};
+
+struct SimMutex {
+  std::timed_mutex mutex;
+};
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char*, uint32_t, void* param, UBaseType_t,
+                                   TaskHandle_t* handle, BaseType_t) {
+  SimTask* task = new SimTask();
+  task->thread = std::thread([fn, param]() {
+    sim::HeapScope scope(true);          // Tasks gehören zur Firmware
+    fn(param);
+  });
+  task->thread.detach();
+  if (handle) *handle = task;
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack, void* param, UBaseType_t prio,
+                       TaskHandle_t* handle) {
+  return xTaskCreatePinnedToCore(fn, name, stack, param, prio, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t) {
+  // Ein Task, der sich selbst löscht, endet hier; fremde Tasks werden in der Simulation nicht abgebrochen
+}
+
+void vTaskDelay(TickType_t ticks) {
+  sim::sleepVirtual(ticks);
+}
+
+TickType_t xTaskGetTickCount() {
+  return (TickType_t)sim::nowMs();
+}
+
+// Wartet auf cond; wait in Ticks (virtuelle ms), portMAX_DELAY = unbegrenzt
+template <typename Lock, typename Cond>
+static bool waitFor(std::condition_variable& cv, Lock& lock, TickType_t wait, Cond cond) {
+  if (wait == portMAX_DELAY) {
+    cv.wait(lock, cond);
+    return true;
+  }
+  return cv.wait_for(lock, std::chrono::microseconds(sim::wallUsForVirtual(wait)), cond);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  SimQueue* q = new SimQueue();
+  q->length = length;
+  q->itemSize = itemSize;
+  return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t wait) {
+  std::unique_lock<std::mutex> lock(q->mutex);
+  if (!waitFor(q->cv, lock, wait, [q]() { return q->items.size() < q->length; })) return pdFALSE;
+  const uint8_t* p = (const uint8_t*)item;
+  q->items.emplace_back(p, p + q->itemSize);
+  q->cv.notify_all();
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t wait) {
+  std::unique_lock<std::mutex> lock(q->mutex);
+  if (!waitFor(q->cv, lock, wait, [q]() { return !q->items.empty(); })) return pdFALSE;
+  memcpy(item, q->items.front().data(), q->itemSize);
+  q->items.pop_front();
+  q->cv.notify_all();
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+  std::lock_guard<std::mutex> lock(q->mutex);
+  return (UBaseType_t)q->items.size();
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return new SimMutex();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t m, TickType_t wait) {
+  if (wait == portMAX_DELAY) {
+    m->mutex.lock();
+    return pdTRUE;
+  }
+  return m->mutex.try_lock_for(std::chrono::microseconds(sim::wallUsForVirtual(wait))) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t m) {
+  m->mutex.unlock();
+  return pdTRUE;
+}
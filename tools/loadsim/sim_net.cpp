@@ -0,0 +1,342 @@
+/*****************************************************
+ * sim_net.cpp – WebServer, HTTPClient und JSON-Parser für die Lastsimulation
+ *****************************************************/
+#include "sim.h"
+
+#include <ArduinoJson.h>
+#include <HTTPClient.h>
+#include <WebServer.h>
+
+#include <netdb.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/* ====================================================
+ * WebServer
+ * ==================================================== */
+static std::string urlDecode(const std::string& s) {
+  std::string out;
+  out.reserve(s.size());
+  for (size_t i = 0; i < s.size(); i++) {
+    if (s[i] == '+') {
+      out += ' ';
+    } else if (s[i] == '%' && i + 2 < s.size()) {
+      out += (char)strtol(s.substr(i + 1, 2).c_str(), nullptr, 16);
+      i += 2;
+    } else {
+      out += s[i];
+    }
+  }
+  return out;
+}
+
+std::string WebServer::Response::header(const std::string& key) const {
+  for (auto& h : headers) {
+    if (strcasecmp(h.first.c_str(), key.c_str()) == 0) return h.second;
+  }
+  return "";
+}
+
+void WebServer::on(const String& uri, HTTPMethod method, THandlerFunction fn) {
+  _routes.push_back({uri.str(), method, fn});
+}
+
+void WebServer::collectHeaders(const char* keys[], size_t count) {
+  _collect.assign(keys, keys + count);
+}
+
+bool WebServer::hasArg(const String& name) const {
+  for (auto& a : _args) {
+    if (a.first == name.str()) return true;
+  }
+  return false;
+}
+
+String WebServer::arg(const String& name) const {
+  for (auto& a : _args) {
+    if (a.first == name.str()) return String(a.second);
+  }
+  return String();
+}
+
+bool WebServer::hasHeader(const String& name) const {
+  return _headers.count(name.str()) > 0;
+}
+
+String WebServer::header(const String& name) const {
+  auto it = _headers.find(name.str());
+  return it == _headers.end() ? String() : String(it->second);
+}
+
+void WebServer::sendHeader(const String& name, const String& value, bool first) {
+  auto h = std::make_pair(name.str(), value.str());
+  if (first) _pendingHeaders.insert(_pendingHeaders.begin(), h);
+  else       _pendingHeaders.push_back(h);
+}
+
+// Die Antwort gehört zur Netzwerkseite und zählt nicht zum Heap der Firmware
+void WebServer::send(int code, const char* contentType, const String& content) {
+  if (!_current) return;
+  sim::HeapScope scope(false);
+  _current->code = code;
+  _current->contentType = contentType ? contentType : "";
+  _current->headers = _pendingHeaders;
+  _current->body.append(content.c_str(), content.length());
+}
+
+void WebServer::sendContent(const char* data, size_t len) {
+  if (!_current) return;
+  sim::HeapScope scope(false);
+  _current->body.append(data, len);
+}
+
+void WebServer::dispatch(Job& job) {
+  uint64_t start = sim::wallUs();
+  job.response.queuedUs = job.enqueuedUs ? start - job.enqueuedUs : 0;
+
+  size_t q = job.uri.find('?');
+  _uri = job.uri.substr(0, q);
+  _method = job.method;
+  _args.clear();
+  if (q != std::string::npos) {
+    std::string query = job.uri.substr(q + 1);
+    size_t pos = 0;
+    while (pos <= query.size()) {
+      size_t amp = query.find('&', pos);
+      std::string pair = query.substr(pos, amp == std::string::npos ? std::string::npos : amp - pos);
+      if (!pair.empty()) {
+        size_t eq = pair.find('=');
+        _args.emplace_back(urlDecode(pair.substr(0, eq)), eq == std::string::npos ? "" : urlDecode(pair.substr(eq + 1)));
+      }
+      if (amp == std::string::npos) break;
+      pos = amp + 1;
+    }
+  }
+  if (!job.body.empty()) _args.emplace_back("plain", job.body);
+
+  // Wie auf dem ESP32 werden nur die per collectHeaders() angemeldeten Header gespeichert
+  _headers.clear();
+  for (auto& key : _collect) {
+    for (auto& h : job.headers) {
+      if (strcasecmp(h.first.c_str(), key.c_str()) == 0) _headers[key] = h.second;
+    }
+  }
+
+  _contentLength = CONTENT_LENGTH_NOT_SET;
+  _pendingHeaders.clear();
+  _current = &job.response;
+  auto pipe = std::make_shared<WiFiPipe>();
+  _client = WiFiClient::attach(pipe);
+
+  bool handled = false;
+  for (RequestHandler* h : _handlers) {
+    if (h->canHandle(job.method, String(_uri))) {
+      handled = h->handle(*this, job.method, String(_uri));
+      break;
+    }
+  }
+  THandlerFunction handler = _notFound;
+  for (auto& r : _routes) {
+    if (r.uri == _uri && (r.method == HTTP_ANY || r.method == job.method)) {
+      handler = r.fn;
+      break;
+    }
+  }
+  if (!handled) {
+    if (handler) handler();
+    else         send(404, "text/plain", "Not found");
+  }
+
+  // Wie auf dem ESP32 schließt der WebServer die Verbindung nach dem Handler, es sei denn, der Handler
+  // hat selbst auf server.client() geantwortet und eine Kopie behalten (Server-Sent Events)
+  _client = WiFiClient();
+  if (job.response.code == 0 && pipe->open) {
+    std::lock_guard<std::mutex> lock(pipe->mutex);
+    if (pipe->data.compare(0, 9, "HTTP/1.1 ") == 0) {
+      job.response.code = atoi(pipe->data.c_str() + 9);
+      job.response.pipe = pipe;
+    }
+  }
+  if (!job.response.pipe) pipe->open = false;
+  _current = nullptr;
+  job.response.serviceUs = sim::wallUs() - start;
+}
+
+void WebServer::handleClient() {
+  Job* job;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_queue.empty()) return;
+    job = _queue.front();
+    _queue.pop_front();
+  }
+  dispatch(*job);
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    job->done = true;
+  }
+  _cv.notify_all();
+}
+
+WebServer::Response WebServer::request(HTTPMethod method, const std::string& uriWithQuery,
+                                       const std::map<std::string, std::string>& headers, const std::string& body) {
+  Job job;
+  job.method = method;
+  job.uri = uriWithQuery;
+  job.headers = headers;
+  job.body = body;
+  std::unique_lock<std::mutex> lock(_mutex);
+  job.enqueuedUs = sim::wallUs();
+  _queue.push_back(&job);
+  _cv.notify_all();
+  _cv.wait(lock, [&job]() { return job.done; });
+  return std::move(job.response);
+}
+
+WebServer::Response WebServer::execute(HTTPMethod method, const std::string& uriWithQuery,
+                                       const std::map<std::string, std::string>& headers, const std::string& body) {
+  Job job;
+  job.method = method;
+  job.uri = uriWithQuery;
+  job.headers = headers;
+  job.body = body;
+  dispatch(job);
+  return std::move(job.response);
+}
+
+size_t WebServer::pending() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _queue.size();
+}
+
+bool WebServer::waitForRequest(uint64_t maxWaitUs) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  return _cv.wait_for(lock, std::chrono::microseconds(maxWaitUs), [this]() { return !_queue.empty(); });
+}
+
+/* ====================================================
+ * HTTPClient (HTTP/1.0, für Tests gegen tools/mock_collector.py)
+ * ==================================================== */
+bool HTTPClient::begin(const String& url) {
+  std::string u = url.str();
+  if (u.compare(0, 7, "http://") != 0) return false;
+  u = u.substr(7);
+  size_t slash = u.find('/');
+  std::string hostPort = u.substr(0, slash);
+  _path = slash == std::string::npos ? "/" : u.substr(slash);
+  size_t colon = hostPort.find(':');
+  _host = hostPort.substr(0, colon);
+  _port = colon == std::string::npos ? 80 : atoi(hostPort.c_str() + colon + 1);
+  _headers.clear();
+  _body.clear();
+  return !_host.empty();
+}
+
+void HTTPClient::addHeader(const String& name, const String& value) {
+  _headers += name.str() + ": " + value.str() + "\r\n";
+}
+
+int HTTPClient::POST(const uint8_t* payload, size_t size) {
+  return request("POST", payload, size);
+}
+
+int HTTPClient::GET() {
+  return request("GET", nullptr, 0);
+}
+
+int HTTPClient::request(const char* method, const uint8_t* payload, size_t size) {
+  _body.clear();
+  struct addrinfo hints = {}, *res = nullptr;
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(_host.c_str(), std::to_string(_port).c_str(), &hints, &res) != 0 || !res) return HTTPC_ERROR_CONNECTION_REFUSED;
+  int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  if (fd < 0) {
+    freeaddrinfo(res);
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+  struct timeval tv = {_timeoutMs / 1000, (_timeoutMs % 1000) * 1000};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  int rc = connect(fd, res->ai_addr, res->ai_addrlen);
+  freeaddrinfo(res);
+  if (rc != 0) {
+    close(fd);
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+
+  std::string head = std::string(method) + " " + _path + " HTTP/1.0\r\nHost: " + _host + "\r\n" + _headers +
+                     "Content-Length: " + std::to_string(size) + "\r\nConnection: close\r\n\r\n";
+  std::string out = head + std::string((const char*)payload, payload ? size : 0);
+  for (size_t sent = 0; sent < out.size();) {
+    ssize_t n = send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0) {
+      close(fd);
+      return -11;                        // HTTPC_ERROR_READ_TIMEOUT
+    }
+    sent += n;
+  }
+  std::string in;
+  char buf[1024];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) in.append(buf, n);
+  close(fd);
+
+  int status = 0;
+  if (sscanf(in.c_str(), "HTTP/%*s %d", &status) != 1) return -11;
+  size_t bodyStart = in.find("\r\n\r\n");
+  if (bodyStart != std::string::npos) _body = in.substr(bodyStart + 4);
+  return status;
+}
+
+/* ====================================================
+ * JSON (nur flache Objekte)
+ * ==================================================== */
+DeserializationError deserializeJson(DynamicJsonDocument& doc, const String& input) {
+  const std::string& s = input.str();
+  size_t i = 0;
+  auto skip = [&]() { while (i < s.size() && isspace((unsigned char)s[i])) i++; };
+  auto readString = [&](std::string& out) {
+    if (i >= s.size() || s[i] != '"') return false;
+    for (i++; i < s.size() && s[i] != '"'; i++) {
+      if (s[i] == '\\' && i + 1 < s.size()) i++;
+      out += s[i];
+    }
+    if (i >= s.size()) return false;
+    i++;
+    return true;
+  };
+
+  doc._values.clear();
+  skip();
+  if (i >= s.size() || s[i] != '{') return DeserializationError::InvalidInput;
+  i++;
+  skip();
+  if (i < s.size() && s[i] == '}') return DeserializationError::Ok;
+  while (i < s.size()) {
+    std::string key, value;
+    skip();
+    if (!readString(key)) return DeserializationError::InvalidInput;
+    skip();
+    if (i >= s.size() || s[i] != ':') return DeserializationError::InvalidInput;
+    i++;
+    skip();
+    if (i < s.size() && s[i] == '"') {
+      if (!readString(value)) return DeserializationError::InvalidInput;
+    } else {
+      while (i < s.size() && s[i] != ',' && s[i] != '}' && !isspace((unsigned char)s[i])) value += s[i++];
+      if (value.empty()) return DeserializationError::InvalidInput;
+    }
+    if (value != "null") doc._values[key] = value;
+    skip();
+    if (i < s.size() && s[i] == ',') {
+      i++;
+      continue;
+    }
+    if (i < s.size() && s[i] == '}') return DeserializationError::Ok;
+    return DeserializationError::InvalidInput;
+  }
+  return DeserializationError::InvalidInput;
+}
@@ -0,0 +1,339 @@
+/*****************************************************
+ * sim_storage.cpp – SPIFFS, NVS (Preferences) und EEPROM für die Lastsimulation
+ *
+ * SPIFFS liegt in einem Verzeichnis des PCs. Gezählt werden alle Bytes, die
+ * die Firmware in den Flash schreibt; bei vollem Dateisystem schlagen
+ * Schreibzugriffe wie auf dem ESP32 fehl.
+ *
+ * NVS-Schreibvorgänge werden in Einträgen zu 32 Byte gezählt, wie sie die
+ * ESP-IDF im Flash ablegt. Unveränderte Werte schreibt die ESP-IDF nicht neu.
+ *****************************************************/
+#include "sim.h"
+
+#include <EEPROM.h>
+#include <Preferences.h>
+#include <SPIFFS.h>
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SPIFFSFS SPIFFS;
+EEPROMClass EEPROM;
+
+/* ====================================================
+ * Dateien
+ * ==================================================== */
+namespace fs {
+
+struct File::Handle {
+  FS*         owner = nullptr;
+  FILE*       file = nullptr;
+  std::string path;                 // Pfad im Flash, z. B. "/outbox/0000002a.gz"
+  std::string name;                 // Dateiname ohne Verzeichnis (wie Arduino-ESP32 2.x)
+  std::string host;                 // Pfad auf dem PC
+  bool        directory = false;
+  std::vector<std::string> entries; // Verzeichnisinhalt
+  size_t      next = 0;
+
+  ~Handle() {
+    if (file) fclose(file);
+  }
+};
+
+static off_t hostFileSize(const std::string& host) {
+  struct stat st;
+  return stat(host.c_str(), &st) == 0 && S_ISREG(st.st_mode) ? st.st_size : 0;
+}
+
+static void makeParents(const std::string& host) {
+  for (size_t p = host.find('/', 1); p != std::string::npos; p = host.find('/', p + 1)) {
+    mkdir(host.substr(0, p).c_str(), 0755);
+  }
+}
+
+std::string FS::hostPath(const String& path) const {
+  std::string p = path.str();
+  if (p.empty() || p[0] != '/') p = "/" + p;
+  return _root + p;
+}
+
+File FS::open(const String& path, const char* mode, bool) {
+  File f;
+  std::string host = hostPath(path);
+  struct stat st;
+  bool isDir = stat(host.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+  std::string m = mode ? mode : FILE_READ;
+
+  auto h = std::make_shared<File::Handle>();
+  h->owner = this;
+  h->path = path.str();
+  h->host = host;
+  h->name = h->path.substr(h->path.find_last_of('/') + 1);
+
+  if (m == FILE_READ && (isDir || path == "/")) {
+    h->directory = true;
+    if (DIR* d = opendir(host.c_str())) {
+      while (struct dirent* e = readdir(d)) {
+        if (strcmp(e->d_name, ".") != 0 && strcmp(e->d_name, "..") != 0) h->entries.push_back(e->d_name);
+      }
+      closedir(d);
+    }
+    std::sort(h->entries.begin(), h->entries.end());
+    f._h = h;
+    return f;
+  }
+  if (m == FILE_READ) {
+    h->file = fopen(host.c_str(), "rb");
+  } else {
+    makeParents(host);
+    if (m == FILE_WRITE) used -= hostFileSize(host);    // Datei wird abgeschnitten
+    h->file = fopen(host.c_str(), m == FILE_APPEND ? "ab" : "wb");
+  }
+  if (h->file) f._h = h;
+  return f;
+}
+
+bool FS::exists(const String& path) {
+  struct stat st;
+  return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const String& path) {
+  std::string host = hostPath(path);
+  off_t size = hostFileSize(host);
+  if (unlink(host.c_str()) != 0) return false;
+  used -= size;
+  return true;
+}
+
+bool FS::rename(const String& from, const String& to) {
+  std::string target = hostPath(to);
+  used -= hostFileSize(target);
+  makeParents(target);
+  return ::rename(hostPath(from).c_str(), target.c_str()) == 0;
+}
+
+size_t File::write(const uint8_t* buf, size_t n) {
+  if (!_h || !_h->file) return 0;
+  FS* owner = _h->owner;
+  if (owner->used + (int64_t)n > (int64_t)owner->capacity) {
+    owner->writeFailures++;
+    return 0;
+  }
+  size_t written = fwrite(buf, 1, n, _h->file);
+  owner->used += written;
+  owner->bytesWritten += written;
+  return written;
+}
+
+int File::available() {
+  if (!_h || !_h->file) return 0;
+  long pos = ftell(_h->file);
+  return (int)(size() - pos);
+}
+
+int File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek() {
+  if (!_h || !_h->file) return -1;
+  int c = fgetc(_h->file);
+  if (c != EOF) ungetc(c, _h->file);
+  return c == EOF ? -1 : c;
+}
+
+size_t File::read(uint8_t* buf, size_t n) {
+  if (!_h || !_h->file) return 0;
+  return fread(buf, 1, n, _h->file);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  if (!_h || !_h->file) return false;
+  int whence = mode == SeekSet ? SEEK_SET : (mode == SeekCur ? SEEK_CUR : SEEK_END);
+  return fseek(_h->file, pos, whence) == 0;
+}
+
+size_t File::position() const {
+  return _h && _h->file ? (size_t)ftell(_h->file) : 0;
+}
+
+size_t File::size() const {
+  if (!_h || !_h->file) return 0;
+  fflush(_h->file);
+  struct stat st;
+  return fstat(fileno(_h->file), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void File::close() {
+  _h.reset();
+}
+
+void File::flush() {
+  if (_h && _h->file) fflush(_h->file);
+}
+
+const char* File::name() const {
+  return _h ? _h->name.c_str() : "";
+}
+
+const char* File::path() const {
+  return _h ? _h->path.c_str() : "";
+}
+
+bool File::isDirectory() const {
+  return _h && _h->directory;
+}
+
+File File::openNextFile(const char* mode) {
+  if (!_h || !_h->directory || _h->next >= _h->entries.size()) return File();
+  std::string base = _h->path == "/" ? "" : _h->path;
+  return _h->owner->open(String(base + "/" + _h->entries[_h->next++]), mode);
+}
+
+time_t File::getLastWrite() {
+  struct stat st;
+  return _h && stat(_h->host.c_str(), &st) == 0 ? st.st_mtime : 0;
+}
+
+}  // namespace fs
+
+// Belegung aus dem Verzeichnis bestimmen (Dateien aus einem früheren Lauf bleiben erhalten)
+static int64_t directorySize(const std::string& host) {
+  int64_t total = 0;
+  DIR* d = opendir(host.c_str());
+  if (!d) return 0;
+  while (struct dirent* e = readdir(d)) {
+    if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
+    std::string child = host + "/" + e->d_name;
+    struct stat st;
+    if (stat(child.c_str(), &st) != 0) continue;
+    total += S_ISDIR(st.st_mode) ? directorySize(child) : st.st_size;
+  }
+  closedir(d);
+  return total;
+}
+
+static void removeTree(const std::string& host) {
+  DIR* d = opendir(host.c_str());
+  if (!d) return;
+  while (struct dirent* e = readdir(d)) {
+    if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
+    std::string child = host + "/" + e->d_name;
+    struct stat st;
+    if (stat(child.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+      removeTree(child);
+      rmdir(child.c_str());
+    } else {
+      unlink(child.c_str());
+    }
+  }
+  closedir(d);
+}
+
+bool SPIFFSFS::begin(bool, const char*, uint8_t, const char*) {
+  if (failBegin) return false;
+  fs::makeParents(_root + "/");
+  used = directorySize(_root);
+  return true;
+}
+
+bool SPIFFSFS::format() {
+  removeTree(_root);
+  used = 0;
+  return true;
+}
+
+/* ====================================================
+ * NVS (Preferences) und EEPROM
+ * ==================================================== */
+typedef std::map<std::string, std::vector<uint8_t>> NvsNamespace;
+static std::map<std::string, NvsNamespace> nvs;
+static std::mutex nvsMutex;
+
+std::atomic<uint64_t> Preferences::bytesWritten{0};
+std::atomic<uint64_t> Preferences::writes{0};
+std::atomic<uint64_t> EEPROMClass::bytesWritten{0};
+
+// Flash-Bedarf eines NVS-Eintrags: 32 Byte Kopf, Daten > 8 Byte in weiteren 32-Byte-Einträgen
+static uint64_t nvsEntryBytes(size_t len) {
+  return len <= 8 ? 32 : 32 + (len + 31) / 32 * 32;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+  std::lock_guard<std::mutex> lock(nvsMutex);
+  std::vector<uint8_t>& slot = nvs[_ns][key];
+  const uint8_t* p = (const uint8_t*)value;
+  if (slot.size() == len && memcmp(slot.data(), p, len) == 0) return len;   // unverändert
+  slot.assign(p, p + len);
+  bytesWritten += nvsEntryBytes(len);
+  writes++;
+  return len;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+  std::lock_guard<std::mutex> lock(nvsMutex);
+  auto ns = nvs.find(_ns);
+  if (ns == nvs.end()) return 0;
+  auto it = ns->second.find(key);
+  if (it == ns->second.end() || it->second.size() > maxLen) return 0;
+  memcpy(buf, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  std::lock_guard<std::mutex> lock(nvsMutex);
+  auto ns = nvs.find(_ns);
+  if (ns == nvs.end()) return 0;
+  auto it = ns->second.find(key);
+  return it == ns->second.end() ? 0 : it->second.size();
+}
+
+bool Preferences::isKey(const char* key) {
+  std::lock_guard<std::mutex> lock(nvsMutex);
+  auto ns = nvs.find(_ns);
+  return ns != nvs.end() && ns->second.count(key) > 0;
+}
+
+bool Preferences::remove(const char* key) {
+  std::lock_guard<std::mutex> lock(nvsMutex);
+  auto ns = nvs.find(_ns);
+  if (ns == nvs.end() || !ns->second.erase(key)) return false;
+  bytesWritten += 32;                 // Eintrag wird als gelöscht markiert
+  writes++;
+  return true;
+}
+
+bool Preferences::clear() {
+  std::lock_guard<std::mutex> lock(nvsMutex);
+  auto ns = nvs.find(_ns);
+  if (ns == nvs.end()) return true;
+  bytesWritten += 32 * ns->second.size();
+  writes += ns->second.size();
+  ns->second.clear();
+  return true;
+}
+
+String Preferences::getString(const char* key, const String& def) {
+  size_t len = getBytesLength(key);
+  if (len == 0) return def;
+  std::vector<char> buf(len);
+  getBytes(key, buf.data(), len);
+  return String(std::string(buf.data(), strnlen(buf.data(), len)));
+}
+
+// Das EEPROM des ESP32 ist selbst ein NVS-Blob, der bei commit() komplett geschrieben wird
+bool EEPROMClass::commit() {
+  if (_data == _committed) return true;
+  _committed = _data;
+  bytesWritten += nvsEntryBytes(_data.size());
+  return true;
+}
@@ -0,0 +1,523 @@
+/*****************************************************
+ * logtool – Auswertung der Logdateien (*_Rohdaten.csv) am PC
+ *
+ * Funktionen:
+ *   - Einlesen per mmap, Zeilen werden mit memchr gesucht (in der libc
+ *     vektorisiert), Zahlen mit dem Parser aus lib/LogFormat (Dezimalkomma
+ *     oder -punkt, ohne locale/stdio)
+ *   - mehrere Dateien parallel auf allen Kernen
+ *   - Statistik je Aufnahme (Min/Max/Mittelwert/Standardabweichung je Kanal),
+ *     Druckdifferenzen und Durchflusssummen
+ *   - Export in ein kompaktes Spaltenformat (*.flc, siehe unten)
+ *   - Benchmark des Parsers in MB/s (--bench, nach einem ungemessenen Aufwärmlauf)
+ *   - Zeitstempel gelten als Ortszeit der Station (LOG_TIMEZONE), unabhängig
+ *     von der Zeitzone des PCs
+ *
+ * Zeilenaufbau und Kopfzeile kommen aus lib/LogFormat/LogFormat.h, also aus
+ * derselben Quelle wie in der Firmware.
+ *
+ * Bauen:
+ *   pio run -e logtool                      (Programm: .pio/build/logtool/program)
+ *   oder direkt:
+ *   g++ -O2 -std=gnu++17 -pthread -Ilib/LogFormat tools/logtool/main.cpp \
+ *       lib/LogFormat/LogFormat.cpp -o logtool
+ *
+ * Beispiele:
+ *   logtool daten/2024-*_Rohdaten.csv
+ *   logtool --csv --dp 1-2,3-4 daten/2024-*.csv > auswertung.csv
+ *   logtool --export spalten/ daten/2024-*.csv
+ *   logtool --bench 256
+ *
+ * Spaltenformat *.flc (Little Endian):
+ *   FlcHeader (32 Byte), danach nacheinander die Spalten mit je rows Werten:
+ *   uint32 Zeitstempel, uint32 Laufzeit, float Druck1..4 (bar),
+ *   float FlowRate1..2 (L/min), double CumulativeFlow1..2 (L)
+ *****************************************************/
+#include <LogFormat.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ====================================================
+ * Datenstrukturen
+ * ==================================================== */
+#define CHANNELS   6        // Druck1..4, FlowRate1..2
+#define GAP_S      10       // größere Zeitsprünge gelten als Lücke (nicht integriert)
+
+static const char* CHANNEL_NAMES[CHANNELS] = {
+  "Druck1 (bar)", "Druck2 (bar)", "Druck3 (bar)", "Druck4 (bar)", "Flow1 (L/min)", "Flow2 (L/min)"
+};
+
+struct FlcHeader {
+  char     magic[4];        // "FLC1"
+  uint16_t version;         // 1
+  uint16_t columns;         // LOG_COLUMNS
+  uint32_t rows;
+  uint32_t reserved;
+  int64_t  firstTimestamp;
+  int64_t  lastTimestamp;
+};
+static_assert(sizeof(FlcHeader) == 32, "FlcHeader muss 32 Byte groß sein");
+
+// Laufende Statistik nach Welford (numerisch stabil, ein Durchlauf)
+struct Stats {
+  uint64_t n = 0;
+  double mean = 0, m2 = 0;
+  double min = INFINITY, max = -INFINITY;
+
+  void add(double v) {
+    n++;
+    double d = v - mean;
+    mean += d / n;
+    m2 += d * (v - mean);
+    if (v < min) min = v;
+    if (v > max) max = v;
+  }
+  double stddev() const { return n > 1 ? std::sqrt(m2 / (n - 1)) : 0.0; }
+};
+
+struct DpPair {
+  int a, b;                 // Kanalnummern 0..3
+};
+
+// Spalten für den Export (nur gefüllt, wenn --export gesetzt ist)
+struct Columns {
+  std::vector<uint32_t> timestamp, runtime;
+  std::vector<float>    channel[CHANNELS];
+  std::vector<double>   cumulative[2];
+};
+
+struct FileResult {
+  std::string name;
+  std::string error;
+  uint64_t bytes = 0;
+  uint64_t rows = 0;
+  uint64_t badLines = 0;
+  uint64_t gaps = 0;
+  time_t   first = 0, last = 0;
+  Stats    channel[CHANNELS];
+  std::vector<Stats> dp;
+  double   integrated[2] = {0, 0};  // L, aus FlowRate über die Zeit
+  double   counter[2] = {0, 0};     // L, Differenz der CumulativeFlow-Spalte
+  double   firstCumulative[2] = {0, 0};
+  Columns  columns;
+};
+
+struct Options {
+  unsigned threads = 0;
+  bool csv = false;
+  std::string exportDir;
+  std::vector<DpPair> dp = {{0, 1}, {2, 3}};
+  std::vector<std::string> files;
+  double benchMb = 0;
+};
+
+/* ====================================================
+ * Auswertung
+ * ==================================================== */
+
+// Verarbeitet einen Speicherbereich mit ganzen Zeilen (Datei oder Benchmark-Puffer)
+static void analyzeBuffer(const char* data, size_t size, const Options& opt, FileResult& r, bool keepColumns) {
+  LogTimeCache cache;
+  LogRow row = {};
+  LogRow prev = {};
+  bool havePrev = false;
+  r.dp.assign(opt.dp.size(), Stats());
+
+  const char* p = data;
+  const char* end = data + size;
+  while (p < end) {
+    const char* nl = (const char*)memchr(p, '\n', end - p);
+    const char* lineEnd = nl ? nl : end;
+    size_t len = lineEnd - p;
+    if (len && p[len - 1] == '\r') len--;
+
+    if (len) {
+      if (!parseLogRow(p, len, row, &cache)) {
+        // Kopfzeile bzw. jede weitere Kopfzeile zählt nicht als Fehler
+        if (memcmp(p, "Zeitstempel", len < 11 ? len : 11) != 0) r.badLines++;
+      } else {
+        float values[CHANNELS] = {
+          row.pressure[0], row.pressure[1], row.pressure[2], row.pressure[3], row.flow[0], row.flow[1]
+        };
+        for (int c = 0; c < CHANNELS; c++) r.channel[c].add(values[c]);
+        for (size_t i = 0; i < opt.dp.size(); i++) {
+          r.dp[i].add(row.pressure[opt.dp[i].a] - row.pressure[opt.dp[i].b]);
+        }
+
+        if (!havePrev) {
+          r.first = row.timestamp;
+          r.firstCumulative[0] = row.cumulative[0];
+          r.firstCumulative[1] = row.cumulative[1];
+        } else {
+          // Trapezregel; über Lücken wird nicht integriert
+          long dt = (long)(row.timestamp - prev.timestamp);
+          if (dt > 0 && dt <= GAP_S) {
+            for (int f = 0; f < 2; f++) r.integrated[f] += (row.flow[f] + prev.flow[f]) * 0.5 * dt / 60.0;
+          } else {
+            r.gaps++;
+          }
+        }
+        r.last = row.timestamp;
+        r.counter[0] = row.cumulative[0] - r.firstCumulative[0];
+        r.counter[1] = row.cumulative[1] - r.firstCumulative[1];
+        r.rows++;
+        prev = row;
+        havePrev = true;
+
+        if (keepColumns) {
+          Columns& col = r.columns;
+          col.timestamp.push_back((uint32_t)row.timestamp);
+          col.runtime.push_back(row.runtime);
+          for (int c = 0; c < CHANNELS; c++) col.channel[c].push_back(values[c]);
+          col.cumulative[0].push_back(row.cumulative[0]);
+          col.cumulative[1].push_back(row.cumulative[1]);
+        }
+      }
+    }
+    p = lineEnd + 1;
+  }
+  r.bytes += size;
+}
+
+static void analyzeFile(const std::string& path, const Options& opt, FileResult& r) {
+  r.name = path;
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    r.error = std::string("kann nicht geöffnet werden: ") + strerror(errno);
+    return;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    r.error = strerror(errno);
+    close(fd);
+    return;
+  }
+  if (st.st_size == 0) {
+    close(fd);
+    return;
+  }
+  void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    r.error = std::string("mmap fehlgeschlagen: ") + strerror(errno);
+    return;
+  }
+  madvise(map, st.st_size, MADV_SEQUENTIAL);
+  analyzeBuffer((const char*)map, st.st_size, opt, r, !opt.exportDir.empty());
+  munmap(map, st.st_size);
+}
+
+// Verteilt die Aufgaben 0..count-1 auf einen einfachen Thread-Pool
+template <typename F>
+static void parallelFor(size_t count, unsigned threads, F work) {
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> pool;
+  unsigned n = threads < count ? threads : (unsigned)count;
+  for (unsigned t = 0; t < n; t++) {
+    pool.emplace_back([&]() {
+      for (size_t i = next++; i < count; i = next++) work(i);
+    });
+  }
+  for (auto& th : pool) th.join();
+}
+
+/* ====================================================
+ * Ausgabe
+ * ==================================================== */
+
+// Zahl mit Dezimalkomma, passend zu den Logdateien und deutschen Tabellenkalkulationen
+static std::string num(double v, int decimals) {
+  if (!std::isfinite(v)) return "";
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+  for (char* c = buf; *c; c++) if (*c == '.') *c = ',';
+  return buf;
+}
+
+static std::string timeString(time_t t) {
+  struct tm tm;
+  localtime_r(&t, &tm);
+  char buf[24];
+  strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+  return buf;
+}
+
+static std::string durationString(long s) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%02ld:%02ld:%02ld", s / 3600, (s / 60) % 60, s % 60);
+  return buf;
+}
+
+static std::string dpName(const DpPair& pair) {
+  return "dP" + std::to_string(pair.a + 1) + "-" + std::to_string(pair.b + 1) + " (bar)";
+}
+
+static void printText(const FileResult& r, const Options& opt) {
+  printf("%s\n", r.name.c_str());
+  if (!r.error.empty()) {
+    printf("  Fehler: %s\n\n", r.error.c_str());
+    return;
+  }
+  if (r.rows == 0) {
+    printf("  keine Messzeilen\n\n");
+    return;
+  }
+  printf("  Beginn %s, Dauer %s, %llu Zeilen, %llu fehlerhaft, %llu Lücken\n",
+         timeString(r.first).c_str(), durationString((long)(r.last - r.first)).c_str(),
+         (unsigned long long)r.rows, (unsigned long long)r.badLines, (unsigned long long)r.gaps);
+  printf("  %-16s %10s %10s %10s %10s\n", "Kanal", "Min", "Max", "Mittel", "StdAbw");
+  auto line = [](const std::string& name, const Stats& s) {
+    printf("  %-16s %10s %10s %10s %10s\n", name.c_str(),
+           num(s.min, 3).c_str(), num(s.max, 3).c_str(), num(s.mean, 3).c_str(), num(s.stddev(), 3).c_str());
+  };
+  for (int c = 0; c < CHANNELS; c++) line(CHANNEL_NAMES[c], r.channel[c]);
+  for (size_t i = 0; i < opt.dp.size(); i++) line(dpName(opt.dp[i]), r.dp[i]);
+  for (int f = 0; f < 2; f++) {
+    printf("  Durchfluss %d: %s L integriert, %s L laut Zähler\n", f + 1,
+           num(r.integrated[f], 2).c_str(), num(r.counter[f], 2).c_str());
+  }
+  printf("\n");
+}
+
+static void printCsvHeader() {
+  printf("Datei;Beginn;Dauer (s);Zeilen;Fehlerhaft;Luecken;Kanal;Min;Max;Mittel;StdAbw\n");
+}
+
+static void printCsv(const FileResult& r, const Options& opt) {
+  if (!r.error.empty() || r.rows == 0) return;
+  auto line = [&](const std::string& name, const Stats& s) {
+    printf("%s;%s;%ld;%llu;%llu;%llu;%s;%s;%s;%s;%s\n", r.name.c_str(), timeString(r.first).c_str(),
+           (long)(r.last - r.first), (unsigned long long)r.rows, (unsigned long long)r.badLines,
+           (unsigned long long)r.gaps, name.c_str(),
+           num(s.min, 3).c_str(), num(s.max, 3).c_str(), num(s.mean, 3).c_str(), num(s.stddev(), 3).c_str());
+  };
+  for (int c = 0; c < CHANNELS; c++) line(CHANNEL_NAMES[c], r.channel[c]);
+  for (size_t i = 0; i < opt.dp.size(); i++) line(dpName(opt.dp[i]), r.dp[i]);
+  for (int f = 0; f < 2; f++) {
+    Stats total;
+    total.add(r.integrated[f]);
+    line("Volumen" + std::to_string(f + 1) + " integriert (L)", total);
+    Stats counter;
+    counter.add(r.counter[f]);
+    line("Volumen" + std::to_string(f + 1) + " Zaehler (L)", counter);
+  }
+}
+
+/* ====================================================
+ * Export (*.flc)
+ * ==================================================== */
+static bool writeColumns(const FileResult& r, const std::string& dir) {
+  std::string base = r.name.substr(r.name.find_last_of('/') + 1);
+  if (base.size() > 4 && base.compare(base.size() - 4, 4, ".csv") == 0) base.resize(base.size() - 4);
+  std::string path = dir + "/" + base + ".flc";
+
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f) {
+    fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+    return false;
+  }
+  FlcHeader h;
+  memcpy(h.magic, "FLC1", 4);
+  h.version = 1;
+  h.columns = LOG_COLUMNS;
+  h.rows = (uint32_t)r.rows;
+  h.reserved = 0;
+  h.firstTimestamp = r.first;
+  h.lastTimestamp = r.last;
+  fwrite(&h, sizeof(h), 1, f);
+
+  const Columns& col = r.columns;
+  fwrite(col.timestamp.data(), sizeof(uint32_t), col.timestamp.size(), f);
+  fwrite(col.runtime.data(), sizeof(uint32_t), col.runtime.size(), f);
+  for (int c = 0; c < CHANNELS; c++) fwrite(col.channel[c].data(), sizeof(float), col.channel[c].size(), f);
+  for (int c = 0; c < 2; c++) fwrite(col.cumulative[c].data(), sizeof(double), col.cumulative[c].size(), f);
+  bool ok = !ferror(f);
+  ok = (fclose(f) == 0) && ok;
+  if (!ok) fprintf(stderr, "%s: Schreibfehler\n", path.c_str());
+  return ok;
+}
+
+/* ====================================================
+ * Benchmark
+ * ==================================================== */
+
+// Erzeugt synthetische Zeilen mit dem Formatierer der Firmware (1 Hz, ab 2024-03-31 00:00,
+// also inklusive Zeitumstellung) und misst den Durchsatz des Parsers.
+static int runBenchmark(const Options& opt) {
+  size_t target = (size_t)(opt.benchMb * 1024 * 1024);
+  std::string data = LOG_CSV_HEADER;
+  data.reserve(target + LOG_ROW_MAX);
+
+  struct tm start = {};
+  start.tm_year = 2024 - 1900;
+  start.tm_mon = 2;
+  start.tm_mday = 31;
+  start.tm_isdst = -1;
+  LogRow row = {};
+  row.timestamp = mktime(&start);
+  row.runtime = 0;
+  row.cumulative[0] = row.cumulative[1] = 0;
+  char line[LOG_ROW_MAX];
+  uint32_t rng = 12345;
+  while (data.size() < target) {
+    for (int i = 0; i < 4; i++) {
+      rng = rng * 1664525u + 1013904223u;
+      row.pressure[i] = 1.0f + i + (rng >> 8) * (1.0f / 16777216.0f);
+    }
+    row.flow[0] = 12.0f + (rng & 0xFF) * 0.01f;
+    row.flow[1] = 6.0f + ((rng >> 8) & 0xFF) * 0.01f;
+    row.cumulative[0] += row.flow[0] / 60.0;
+    row.cumulative[1] += row.flow[1] / 60.0;
+    data.append(line, formatLogRow(row, line, sizeof(line)));
+    row.timestamp++;
+    row.runtime++;
+  }
+  double mb = data.size() / (1024.0 * 1024.0);
+  printf("Benchmark: %.1f MB synthetische Logdaten\n", mb);
+
+  auto seconds = [](std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  };
+
+  // Aufwärmlauf (nicht gemessen): Seiten des Puffers und Caches sind danach für alle Läufe gleich warm
+  FileResult warmup;
+  analyzeBuffer(data.data(), data.size(), opt, warmup, false);
+
+  // 1 Thread über den ganzen Puffer
+  FileResult single;
+  auto t0 = std::chrono::steady_clock::now();
+  analyzeBuffer(data.data(), data.size(), opt, single, false);
+  double s = seconds(t0);
+  printf("  1 Thread:  %8.1f MB/s  (%llu Zeilen, %llu fehlerhaft)\n", mb / s,
+         (unsigned long long)single.rows, (unsigned long long)single.badLines);
+
+  // N Threads, Puffer an Zeilengrenzen in N Teile geteilt (wie N Dateien)
+  unsigned n = opt.threads;
+  std::vector<size_t> cuts = {0};
+  for (unsigned i = 1; i < n; i++) {
+    size_t pos = data.size() * i / n;
+    const char* nl = (const char*)memchr(data.data() + pos, '\n', data.size() - pos);
+    cuts.push_back(nl ? nl - data.data() + 1 : data.size());
+  }
+  cuts.push_back(data.size());
+  std::vector<FileResult> parts(n);
+  t0 = std::chrono::steady_clock::now();
+  parallelFor(n, n, [&](size_t i) {
+    analyzeBuffer(data.data() + cuts[i], cuts[i + 1] - cuts[i], opt, parts[i], false);
+  });
+  s = seconds(t0);
+  uint64_t rows = 0;
+  for (auto& part : parts) rows += part.rows;
+  printf("  %u %s %8.1f MB/s  (%llu Zeilen)\n", n, n == 1 ? "Thread: " : "Threads:", mb / s, (unsigned long long)rows);
+  return rows == single.rows ? 0 : 1;
+}
+
+/* ====================================================
+ * Kommandozeile
+ * ==================================================== */
+static void usage() {
+  fprintf(stderr,
+          "Aufruf: logtool [Optionen] Datei.csv ...\n"
+          "  --threads N     Anzahl Threads (Standard: alle Kerne)\n"
+          "  --csv           Statistik als CSV (Semikolon, Dezimalkomma) statt Tabelle\n"
+          "  --dp A-B,...    Druckdifferenzen (Standard: 1-2,3-4)\n"
+          "  --export DIR    Spaltenformat *.flc in DIR schreiben\n"
+          "  --bench [MB]    Parser-Benchmark mit synthetischen Daten (Standard: 128 MB)\n");
+}
+
+static bool parseDp(const char* arg, std::vector<DpPair>& out) {
+  out.clear();
+  const char* p = arg;
+  while (*p) {
+    int a, b, used = 0;
+    if (sscanf(p, "%d-%d%n", &a, &b, &used) != 2 || a < 1 || a > 4 || b < 1 || b > 4) return false;
+    out.push_back({a - 1, b - 1});
+    p += used;
+    if (*p == ',') p++;
+    else if (*p) return false;
+  }
+  return !out.empty();
+}
+
+int main(int argc, char** argv) {
+  // Zeitstempel sind Ortszeit der Station: unabhängig von der Zeitzone des PCs einlesen
+  setenv("TZ", LOG_TIMEZONE, 1);
+  tzset();
+
+  Options opt;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--threads" && i + 1 < argc) {
+      opt.threads = (unsigned)atoi(argv[++i]);
+    } else if (arg == "--csv") {
+      opt.csv = true;
+    } else if (arg == "--dp" && i + 1 < argc) {
+      if (!parseDp(argv[++i], opt.dp)) {
+        fprintf(stderr, "Ungültige Druckdifferenz: %s\n", argv[i]);
+        return 2;
+      }
+    } else if (arg == "--export" && i + 1 < argc) {
+      opt.exportDir = argv[++i];
+    } else if (arg == "--bench") {
+      opt.benchMb = 128;
+      if (i + 1 < argc && argv[i + 1][0] != '-') opt.benchMb = atof(argv[++i]);
+    } else if (arg == "-h" || arg == "--help") {
+      usage();
+      return 0;
+    } else if (!arg.empty() && arg[0] == '-') {
+      usage();
+      return 2;
+    } else {
+      opt.files.push_back(arg);
+    }
+  }
+  if (opt.threads == 0) opt.threads = std::thread::hardware_concurrency();
+  if (opt.threads == 0) opt.threads = 1;
+
+  if (opt.benchMb > 0) return runBenchmark(opt);
+  if (opt.files.empty()) {
+    usage();
+    return 2;
+  }
+
+  std::vector<FileResult> results(opt.files.size());
+  auto t0 = std::chrono::steady_clock::now();
+  parallelFor(opt.files.size(), opt.threads, [&](size_t i) {
+    analyzeFile(opt.files[i], opt, results[i]);
+  });
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  int rc = 0;
+  uint64_t bytes = 0, rows = 0;
+  if (opt.csv) printCsvHeader();
+  for (auto& r : results) {
+    if (opt.csv) printCsv(r, opt);
+    else         printText(r, opt);
+    if (!r.error.empty()) {
+      if (opt.csv) fprintf(stderr, "%s: %s\n", r.name.c_str(), r.error.c_str());
+      rc = 1;
+      continue;
+    }
+    if (!opt.exportDir.empty() && r.rows && !writeColumns(r, opt.exportDir)) rc = 1;
+    bytes += r.bytes;
+    rows += r.rows;
+  }
+  fprintf(stderr, "%zu Dateien, %llu Zeilen, %.1f MB in %.2f s (%.1f MB/s, %u Threads)\n",
+          results.size(), (unsigned long long)rows, bytes / (1024.0 * 1024.0), seconds,
+          seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0, opt.threads);
+  return rc;
+}
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""
+mock_collector.py – Lokaler Collector zum Testen des Telemetrie-Uplinks
+
+Nimmt die Pakete der Messstation (POST, Format "FLB1", optional gzip) entgegen,
+dekodiert sie und prüft, ob die Paketnummern je Station lückenlos und in
+Reihenfolge ankommen. Ausfälle lassen sich simulieren, um Outbox, Wiederholungen
+und Nachsenden zu testen.
+
+Beispiel:
+    python3 tools/mock_collector.py --port 8080 --outage 120 --fail-rate 0.2
+    (auf der Station: /api/uplink mit "url": "http://<PC-IP>:8080/ingest")
+"""
+import argparse
+import gzip
+import json
+import random
+import struct
+import sys
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+HEADER = struct.Struct("<4sIIHH")     # magic, seq, firstTime, count, flags
+SAMPLE = struct.Struct("<H4h2H")      # dt, Druck1..4 (mbar), Flow1..2 (0,01 L/min)
+
+
+def decode_batch(payload):
+    magic, seq, first_time, count, flags = HEADER.unpack_from(payload, 0)
+    if magic != b"FLB1":
+        raise ValueError("unbekanntes Paketformat")
+    if len(payload) != HEADER.size + count * SAMPLE.size:
+        raise ValueError("Paketlänge passt nicht zur Anzahl Messwerte")
+    samples = []
+    for i in range(count):
+        dt, p1, p2, p3, p4, f1, f2 = SAMPLE.unpack_from(payload, HEADER.size + i * SAMPLE.size)
+        samples.append({
+            "time": first_time + dt,
+            "pressure": [p / 1000.0 for p in (p1, p2, p3, p4)],
+            "flow": [f1 / 100.0, f2 / 100.0],
+        })
+    return seq, samples
+
+
+class Collector:
+    def __init__(self, args):
+        self.args = args
+        self.started = time.time()
+        self.next_seq = {}        # erwartete nächste Paketnummer je Station
+        self.batches = 0
+        self.samples = 0
+        self.duplicates = 0
+        self.gaps = 0
+        self.out = open(args.out, "a") if args.out else None
+
+    def should_fail(self):
+        if time.time() - self.started < self.args.outage:
+            return True
+        return random.random() < self.args.fail_rate
+
+    def accept(self, station, seq_header, payload, encoding):
+        if encoding == "gzip":
+            payload = gzip.decompress(payload)
+        seq, samples = decode_batch(payload)
+        if seq_header is not None and int(seq_header) != seq:
+            raise ValueError("X-Batch-Seq passt nicht zum Paketinhalt")
+
+        expected = self.next_seq.get(station)
+        if expected is not None and seq < expected:
+            self.duplicates += 1          # bereits erhalten (z.B. Antwort ging verloren)
+            return "duplicate"
+        if expected is not None and seq > expected:
+            self.gaps += 1                # Station hat Pakete verworfen
+        self.next_seq[station] = seq + 1
+        self.batches += 1
+        self.samples += len(samples)
+
+        if self.out:
+            for sample in samples:
+                self.out.write(json.dumps(dict(station=station, seq=seq, **sample)) + "\n")
+            self.out.flush()
+        return "ok"
+
+    def summary(self):
+        return {
+            "batches": self.batches,
+            "samples": self.samples,
+            "duplicates": self.duplicates,
+            "gaps": self.gaps,
+            "stations": self.next_seq,
+        }
+
+
+def make_handler(collector):
+    class Handler(BaseHTTPRequestHandler):
+        def do_POST(self):
+            length = int(self.headers.get("Content-Length", 0))
+            payload = self.rfile.read(length)
+            if collector.should_fail():
+                self.reply(503, {"status": "unavailable"})
+                return
+            try:
+                result = collector.accept(self.headers.get("X-Station", "?"),
+                                          self.headers.get("X-Batch-Seq"),
+                                          payload,
+                                          self.headers.get("Content-Encoding", ""))
+            except (ValueError, OSError, struct.error) as err:
+                self.reply(400, {"status": "error", "message": str(err)})
+                return
+            self.reply(200, {"status": result})
+
+        def do_GET(self):
+            # GET /stats liefert die bisherige Zusammenfassung
+            self.reply(200, collector.summary())
+
+        def reply(self, code, body):
+            data = json.dumps(body).encode()
+            self.send_response(code)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(data)))
+            self.end_headers()
+            self.wfile.write(data)
+
+        def log_message(self, fmt, *args):
+            if not collector.args.quiet:
+                sys.stderr.write("%s - %s\n" % (self.address_string(), fmt % args))
+
+    return Handler
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Mock-Collector für den Telemetrie-Uplink")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--fail-rate", type=float, default=0.0, help="Anteil der Anfragen, die mit 503 beantwortet werden")
+    parser.add_argument("--outage", type=float, default=0.0, help="Sekunden nach dem Start, in denen alles mit 503 beantwortet wird")
+    parser.add_argument("--out", help="Messwerte als JSON Lines in diese Datei schreiben")
+    parser.add_argument("--quiet", action="store_true")
+    args = parser.parse_args()
+
+    collector = Collector(args)
+    server = ThreadingHTTPServer(("", args.port), make_handler(collector))
+    print("Mock-Collector lauscht auf Port %d" % args.port, file=sys.stderr)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    print(json.dumps(collector.summary(), indent=2))
+
+
+if __name__ == "__main__":
+    main()